@@ -0,0 +1,181 @@
+#include "AllocationAudit.h"
+
+#ifdef WOR_ALLOCATION_AUDIT
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <format>
+#include <new>
+
+#include "Ers/Logger.h"
+
+namespace
+{
+    using WealthOfRows::AllocationAudit::Event;
+    using WealthOfRows::AllocationAudit::Phase;
+
+    struct Counter
+    {
+        std::atomic<uint64_t> Allocations{0};
+        std::atomic<uint64_t> Bytes{0};
+        std::atomic<uint64_t> Events{0};
+    };
+
+    constexpr size_t PhaseCount = static_cast<size_t>(Phase::Count);
+    constexpr size_t EventCount = static_cast<size_t>(Event::Count);
+
+    // Constant initialized, so allocations made before main are counted safely as well
+    std::array<std::array<Counter, EventCount>, PhaseCount> g_Counters;
+    std::atomic<Phase> g_Phase{Phase::Idle};
+    thread_local Event t_Event = Event::Engine;
+
+    Counter& CurrentCounter()
+    {
+        return g_Counters[static_cast<size_t>(g_Phase.load(std::memory_order_relaxed))][static_cast<size_t>(t_Event)];
+    }
+
+    void* Allocate(std::size_t size) noexcept
+    {
+        Counter& counter = CurrentCounter();
+        counter.Allocations.fetch_add(1, std::memory_order_relaxed);
+        counter.Bytes.fetch_add(size, std::memory_order_relaxed);
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    const char* PhaseName(size_t phase)
+    {
+        constexpr std::array<const char*, PhaseCount> names{"idle", "build", "run", "reset", "teardown"};
+        return names[phase];
+    }
+
+    const char* EventName(size_t event)
+    {
+        constexpr std::array<const char*, EventCount> names{"engine", "create tote", "delay or move", "send tote", "receive tote", "time step",
+                                                            "return credit"};
+        return names[event];
+    }
+} // namespace
+
+namespace WealthOfRows::AllocationAudit
+{
+    void SetPhase(Phase phase)
+    {
+        g_Phase.store(phase, std::memory_order_relaxed);
+    }
+
+    void Reset()
+    {
+        for (auto& phaseCounters : g_Counters)
+        {
+            for (auto& counter : phaseCounters)
+            {
+                counter.Allocations.store(0, std::memory_order_relaxed);
+                counter.Bytes.store(0, std::memory_order_relaxed);
+                counter.Events.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void Report(uint64_t generatedTotes)
+    {
+        for (size_t phase = static_cast<size_t>(Phase::Build); phase < PhaseCount; phase++)
+        {
+            uint64_t phaseAllocations = 0;
+            for (size_t event = 0; event < EventCount; event++)
+            {
+                const Counter& counter     = g_Counters[phase][event];
+                const uint64_t allocations = counter.Allocations.load(std::memory_order_relaxed);
+                const uint64_t events      = counter.Events.load(std::memory_order_relaxed);
+                phaseAllocations += allocations;
+                if (allocations == 0 && events == 0)
+                {
+                    continue;
+                }
+
+                const double perEvent = events == 0 ? 0.0 : static_cast<double>(allocations) / static_cast<double>(events);
+                Ers::Logger::Info(std::format(
+                    "[Allocation audit] {}/{}: {} allocations, {} bytes, {} events, {:.3f} allocations per event", PhaseName(phase),
+                    EventName(event), allocations, counter.Bytes.load(std::memory_order_relaxed), events, perEvent));
+            }
+
+            if (phase == static_cast<size_t>(Phase::Run) && generatedTotes > 0)
+            {
+                Ers::Logger::Info(std::format(
+                    "[Allocation audit] run: {:.3f} allocations per generated tote",
+                    static_cast<double>(phaseAllocations) / static_cast<double>(generatedTotes)));
+            }
+        }
+    }
+
+    EventScope::EventScope(Event event) :
+        PreviousEvent(t_Event)
+    {
+        t_Event = event;
+        CurrentCounter().Events.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    EventScope::~EventScope()
+    {
+        t_Event = PreviousEvent;
+    }
+} // namespace WealthOfRows::AllocationAudit
+
+// Global replacements count every allocation made through new, including those made by the engine library where the platform
+// resolves them to this executable. Over-aligned allocations and direct malloc calls are not counted.
+void* operator new(std::size_t size)
+{
+    void* memory = Allocate(size);
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return Allocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+
+// Opt-in heap allocation audit, enabled by building with WOR_ALLOCATION_AUDIT.
+// Without it every function below is an empty inline function, so the model pays nothing for the instrumentation.
+namespace WealthOfRows::AllocationAudit
+{
+    enum class Phase : uint8_t
+    {
+        Idle,
+        Build,
+        Run,
+        Reset,
+        Teardown,
+        Count,
+    };
+
+    // What was running on the allocating thread, Engine covers everything outside the event handlers of the model
+    enum class Event : uint8_t
+    {
+        Engine,
+        CreateTote,
+        DelayOrMove,
+        SendTote,
+        ReceiveTote,
+        TimeStep,
+        ReturnCredit,
+        Count,
+    };
+
+#ifdef WOR_ALLOCATION_AUDIT
+    void SetPhase(Phase phase);
+    void Reset();
+
+    // Logs the counters of every phase and event type, run phase allocations are also reported per generated tote
+    void Report(uint64_t generatedTotes);
+
+    // Attributes the allocations made on this thread to an event type, and counts the event, for the lifetime of the scope
+    class EventScope
+    {
+      public:
+        explicit EventScope(Event event);
+        ~EventScope();
+
+        EventScope(const EventScope&)            = delete;
+        EventScope& operator=(const EventScope&) = delete;
+
+      private:
+        Event PreviousEvent;
+    };
+#else
+    inline void SetPhase(Phase)
+    {
+    }
+
+    inline void Reset()
+    {
+    }
+
+    inline void Report(uint64_t)
+    {
+    }
+
+    class EventScope
+    {
+      public:
+        explicit EventScope(Event)
+        {
+        }
+    };
+#endif
+} // namespace WealthOfRows::AllocationAudit
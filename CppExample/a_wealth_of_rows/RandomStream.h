@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+namespace WealthOfRows
+{
+    // What a random stream is drawn for, every conveyor has an independent stream per purpose
+    enum class RandomPurpose : uint64_t
+    {
+        ToteArrival,
+        DelayChance,
+        DelayLength,
+    };
+
+    // SplitMix64 generator, small enough to keep one per conveyor and purpose.
+    // A draw on one stream never shifts the numbers of another stream, so two scenarios run with the same seed use the same
+    // random numbers for the same decisions (common random numbers), even when one of them makes more draws.
+    struct RandomStream
+    {
+        uint64_t State{0};
+
+        static RandomStream Create(uint64_t seed, uint64_t lineIndex, uint64_t conveyorIndex, RandomPurpose purpose)
+        {
+            // Mix the keys in one at a time, so streams with neighbouring keys are unrelated
+            uint64_t state = Mix(seed + Increment);
+            state          = Mix(state ^ lineIndex);
+            state          = Mix(state ^ conveyorIndex);
+            state          = Mix(state ^ static_cast<uint64_t>(purpose));
+            return RandomStream{state};
+        }
+
+        // Uniform in [0, 1)
+        double Sample()
+        {
+            State += Increment;
+            return static_cast<double>(Mix(State) >> 11) * 0x1.0p-53;
+        }
+
+      private:
+        static constexpr uint64_t Increment = 0x9E3779B97F4A7C15ull;
+
+        static uint64_t Mix(uint64_t value)
+        {
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+            return value ^ (value >> 31);
+        }
+    };
+} // namespace WealthOfRows
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace WealthOfRows
+{
+    // FIFO with a power-of-two slot array that doubles when full and never shrinks.
+    // Once a conveyor has seen its peak occupancy, pushing and popping no longer allocates.
+    template <typename T>
+    class RingBuffer
+    {
+      public:
+        bool Empty() const { return Count == 0; }
+        uint64_t Size() const { return Count; }
+
+        T& Front() { return Slots[Head]; }
+        const T& Front() const { return Slots[Head]; }
+
+        void Push(const T& value)
+        {
+            if (Count == Slots.size())
+            {
+                Grow(Slots.empty() ? 1 : Slots.size() * 2);
+            }
+            Slots[(Head + Count) & (Slots.size() - 1)] = value;
+            Count++;
+        }
+
+        void Pop()
+        {
+            assert(Count > 0);
+            Head = (Head + 1) & (Slots.size() - 1);
+            Count--;
+        }
+
+        // Removes the first element equal to value and keeps the order of the others, returns false when there is none.
+        // Linear in the size, but the front, the common case, is removed like Pop.
+        bool Remove(const T& value)
+        {
+            const uint64_t mask = Slots.size() - 1;
+            for (uint64_t i = 0; i < Count; i++)
+            {
+                if (!(Slots[(Head + i) & mask] == value))
+                {
+                    continue;
+                }
+
+                if (i == 0)
+                {
+                    Pop();
+                    return true;
+                }
+
+                for (uint64_t j = i + 1; j < Count; j++)
+                {
+                    Slots[(Head + j - 1) & mask] = Slots[(Head + j) & mask];
+                }
+                Count--;
+                return true;
+            }
+            return false;
+        }
+
+        void Clear()
+        {
+            Head  = 0;
+            Count = 0;
+        }
+
+        void Reserve(uint64_t capacity)
+        {
+            uint64_t slotCount = 1;
+            while (slotCount < capacity)
+            {
+                slotCount *= 2;
+            }
+            if (slotCount > Slots.size())
+            {
+                Grow(slotCount);
+            }
+        }
+
+        // Public so that owning components can serialize the buffer field by field
+        std::vector<T> Slots;
+        uint64_t Head{0};
+        uint64_t Count{0};
+
+      private:
+        void Grow(uint64_t slotCount)
+        {
+            // Unwrap the live window to the start of the new slot array
+            std::vector<T> grown(slotCount);
+            for (uint64_t i = 0; i < Count; i++)
+            {
+                grown[i] = Slots[(Head + i) & (Slots.size() - 1)];
+            }
+            Slots = std::move(grown);
+            Head  = 0;
+        }
+    };
+} // namespace WealthOfRows
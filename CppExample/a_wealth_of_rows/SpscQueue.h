@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace WealthOfRows
+{
+    // Bounded lock-free FIFO for exactly one producer thread and one consumer thread.
+    // Neither side ever blocks or allocates: TryPush fails when the queue is full and TryPop fails when it is empty.
+    template <typename T>
+    class SpscQueue
+    {
+      public:
+        // The capacity is rounded up to a power of two
+        explicit SpscQueue(uint64_t capacity)
+        {
+            uint64_t slotCount = 1;
+            while (slotCount < capacity)
+            {
+                slotCount *= 2;
+            }
+            Slots.resize(slotCount);
+            Mask = slotCount - 1;
+        }
+
+        SpscQueue(const SpscQueue&)            = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        uint64_t Capacity() const { return Slots.size(); }
+
+        // Producer side
+        bool TryPush(const T& value)
+        {
+            const uint64_t tail = Tail.load(std::memory_order_relaxed);
+            if (tail - CachedHead == Slots.size())
+            {
+                // Only look at the consumer's index when the cached one says the queue is full
+                CachedHead = Head.load(std::memory_order_acquire);
+                if (tail - CachedHead == Slots.size())
+                {
+                    return false;
+                }
+            }
+
+            Slots[tail & Mask] = value;
+            Tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side
+        bool TryPop(T& value)
+        {
+            const uint64_t head = Head.load(std::memory_order_relaxed);
+            if (head == CachedTail)
+            {
+                CachedTail = Tail.load(std::memory_order_acquire);
+                if (head == CachedTail)
+                {
+                    return false;
+                }
+            }
+
+            value = Slots[head & Mask];
+            Head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+      private:
+        // Keeps the indices of the producer and the consumer on separate cache lines
+        static constexpr size_t CacheLineSize = 64;
+
+        std::vector<T> Slots;
+        uint64_t Mask{0};
+
+        // Written by the producer
+        alignas(CacheLineSize) std::atomic<uint64_t> Tail{0};
+        uint64_t CachedHead{0};
+
+        // Written by the consumer
+        alignas(CacheLineSize) std::atomic<uint64_t> Head{0};
+        uint64_t CachedTail{0};
+    };
+} // namespace WealthOfRows
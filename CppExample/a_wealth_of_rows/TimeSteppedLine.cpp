@@ -0,0 +1,145 @@
+#include "TimeSteppedLine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+    // The kernels of a step, one loop each. Every array is a vector of its own, so the arrays never overlap. The __restrict parameters
+    // tell the compiler so, which spares the vectorized loops a runtime overlap check and a scalar fallback.
+
+    // Counts down the time the totes still have to spend on their segment
+    void CountDown(int32_t* __restrict remainingSteps, size_t segmentCount)
+    {
+        for (size_t i = 0; i < segmentCount; i++)
+        {
+            remainingSteps[i] = std::max(remainingSteps[i] - 1, 0);
+        }
+    }
+
+    // A tote moves when it is ready and the next segment was empty at the start of the step, the last segment moves out of the line
+    void FindMoves(
+        const uint8_t* __restrict occupied, const int32_t* __restrict remainingSteps, uint8_t* __restrict moves, size_t segmentCount)
+    {
+        for (size_t i = 0; i + 1 < segmentCount; i++)
+        {
+            moves[i] = occupied[i] & static_cast<uint8_t>(remainingSteps[i] == 0) & static_cast<uint8_t>(occupied[i + 1] ^ 1);
+        }
+        moves[segmentCount - 1] = occupied[segmentCount - 1] & static_cast<uint8_t>(remainingSteps[segmentCount - 1] == 0);
+    }
+
+    // Shifts the moving totes one segment forward, the segment a tote moves into was empty so at most one of both applies.
+    // Returns the number of totes that moved to the next segment.
+    uint64_t ShiftOccupied(
+        const uint8_t* __restrict occupied, const uint8_t* __restrict moves, uint8_t* __restrict nextOccupied, size_t segmentCount)
+    {
+        nextOccupied[0]     = occupied[0] & static_cast<uint8_t>(moves[0] ^ 1);
+        uint64_t movedTotes = 0;
+        for (size_t i = 1; i < segmentCount; i++)
+        {
+            const uint8_t entered = moves[i - 1];
+            nextOccupied[i]       = (occupied[i] & static_cast<uint8_t>(moves[i] ^ 1)) | entered;
+            movedTotes += entered;
+        }
+        return movedTotes;
+    }
+
+    void ShiftTotes(const uint64_t* __restrict totes, const uint8_t* __restrict moves, uint64_t* __restrict nextTotes, size_t segmentCount)
+    {
+        nextTotes[0] = totes[0];
+        for (size_t i = 1; i < segmentCount; i++)
+        {
+            // Selects with a mask instead of a branch
+            const uint64_t enteredMask = uint64_t(0) - moves[i - 1];
+            nextTotes[i]               = (totes[i - 1] & enteredMask) | (totes[i] & ~enteredMask);
+        }
+    }
+
+    // A tote that entered a segment stays there for the minimum steps
+    void ShiftRemainingSteps(
+        const int32_t* __restrict remainingSteps, const uint8_t* __restrict moves, int32_t* __restrict nextRemainingSteps,
+        int32_t minimumSteps, size_t segmentCount)
+    {
+        nextRemainingSteps[0] = remainingSteps[0];
+        for (size_t i = 1; i < segmentCount; i++)
+        {
+            const int32_t enteredMask = -static_cast<int32_t>(moves[i - 1]);
+            nextRemainingSteps[i]     = (minimumSteps & enteredMask) | (remainingSteps[i] & ~enteredMask);
+        }
+    }
+} // namespace
+
+namespace WealthOfRows
+{
+    void TimeSteppedLine::Resize(uint64_t segmentCount)
+    {
+        segmentCount = std::max<uint64_t>(segmentCount, 1);
+
+        Occupied.assign(segmentCount, 0);
+        NextOccupied.assign(segmentCount, 0);
+        RemainingSteps.assign(segmentCount, 0);
+        NextRemainingSteps.assign(segmentCount, 0);
+        Totes.assign(segmentCount, 0);
+        NextTotes.assign(segmentCount, 0);
+        Moves.assign(segmentCount, 0);
+    }
+
+    bool TimeSteppedLine::Step(RandomStream& delayChanceStream, RandomStream& delayLengthStream, uint64_t& exitedTote)
+    {
+        const size_t segmentCount = Occupied.size();
+
+        CountDown(RemainingSteps.data(), segmentCount);
+        FindMoves(Occupied.data(), RemainingSteps.data(), Moves.data(), segmentCount);
+        MovedTotes += ShiftOccupied(Occupied.data(), Moves.data(), NextOccupied.data(), segmentCount);
+        ShiftTotes(Totes.data(), Moves.data(), NextTotes.data(), segmentCount);
+        ShiftRemainingSteps(RemainingSteps.data(), Moves.data(), NextRemainingSteps.data(), MinimumSteps, segmentCount);
+
+        // Delays are drawn per entered tote, which only the lines with a chance of delay pay for
+        if (ChanceOfDelay > 0)
+        {
+            for (size_t i = 1; i < segmentCount; i++)
+            {
+                if (Moves[i - 1])
+                {
+                    NextRemainingSteps[i] = EntrySteps(delayChanceStream, delayLengthStream);
+                }
+            }
+        }
+
+        const bool exited = Moves[segmentCount - 1] != 0;
+        exitedTote        = Totes[segmentCount - 1];
+
+        std::swap(Occupied, NextOccupied);
+        std::swap(RemainingSteps, NextRemainingSteps);
+        std::swap(Totes, NextTotes);
+
+        // The source puts its oldest waiting tote on the first segment as soon as that is empty
+        if (PendingTotes > 0 && !Occupied[0])
+        {
+            Occupied[0]       = 1;
+            Totes[0]          = GeneratedTotes - PendingTotes;
+            RemainingSteps[0] = EntrySteps(delayChanceStream, delayLengthStream);
+            PendingTotes--;
+            MovedTotes++;
+        }
+
+        return exited;
+    }
+
+    int32_t TimeSteppedLine::EntrySteps(RandomStream& delayChanceStream, RandomStream& delayLengthStream) const
+    {
+        int32_t steps = MinimumSteps;
+        if (ChanceOfDelay == 0)
+        {
+            return steps;
+        }
+
+        // An event driven conveyor draws again after every delay, so a tote can be delayed more than once
+        while (delayChanceStream.Sample() * 100.0 <= static_cast<double>(ChanceOfDelay))
+        {
+            steps += DelayStepsMin + static_cast<int32_t>(std::lround(delayLengthStream.Sample() * (DelayStepsMax - DelayStepsMin)));
+        }
+        return steps;
+    }
+} // namespace WealthOfRows
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RandomStream.h"
+
+namespace WealthOfRows
+{
+    // A line of conveyor segments that is advanced in fixed time steps instead of event by event.
+    // Every segment holds at most one tote. The state of the segments is kept in contiguous arrays, one per field, and every step
+    // computes the next state from the current one with branch-free loops that the compiler vectorizes.
+    // A tote moves at most one segment per step: it leaves a segment once its remaining steps reached zero and the next segment was
+    // empty at the start of the step.
+    struct TimeSteppedLine
+    {
+        // Per segment, the current state and the state being computed by a step
+        std::vector<uint8_t> Occupied;
+        std::vector<uint8_t> NextOccupied;
+        std::vector<int32_t> RemainingSteps;
+        std::vector<int32_t> NextRemainingSteps;
+        std::vector<uint64_t> Totes;
+        std::vector<uint64_t> NextTotes;
+
+        // Whether the tote in a segment moves on in the current step, the last segment moves out of the line
+        std::vector<uint8_t> Moves;
+
+        int32_t MinimumSteps{1};
+        uint64_t ChanceOfDelay{0};
+        int32_t DelayStepsMin{1};
+        int32_t DelayStepsMax{1};
+
+        // Totes that arrived at the source but did not fit on the first segment yet
+        uint64_t PendingTotes{0};
+        uint64_t GeneratedTotes{0};
+        uint64_t MovedTotes{0};
+
+        void Resize(uint64_t segmentCount);
+
+        // Advances the line by one step. Returns true when a tote left the last segment, its ID is written to exitedTote.
+        bool Step(RandomStream& delayChanceStream, RandomStream& delayLengthStream, uint64_t& exitedTote);
+
+      private:
+        int32_t EntrySteps(RandomStream& delayChanceStream, RandomStream& delayLengthStream) const;
+    };
+} // namespace WealthOfRows
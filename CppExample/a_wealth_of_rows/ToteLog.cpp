@@ -0,0 +1,435 @@
+#include "ToteLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <unordered_map>
+
+#include "Ers/Logger.h"
+
+namespace
+{
+    using WealthOfRows::ToteLog::Record;
+    using WealthOfRows::ToteLog::RecordType;
+
+    constexpr char FileMagic[8] = {'W', 'O', 'R', 'T', 'L', 'O', 'G', '1'};
+
+    // Records are buffered per block, every block stores its columns one after the other
+    constexpr size_t BlockSize   = 1 << 16;
+    constexpr size_t ColumnCount = 5;
+
+    // The values of a column are stored as the zigzag encoded delta to the previous record of the block, as a varint.
+    // The writer drains one producer at a time, so neighbouring records mostly share the line and differ little in time and tote.
+    int64_t ColumnValue(const Record& record, size_t column)
+    {
+        switch (column)
+        {
+        case 0:
+            return record.Time;
+        case 1:
+            return static_cast<int64_t>(record.Tote);
+        case 2:
+            return record.Line;
+        case 3:
+            return record.Conveyor;
+        default:
+            return static_cast<int64_t>(record.Type);
+        }
+    }
+
+    void SetColumnValue(Record& record, size_t column, int64_t value)
+    {
+        switch (column)
+        {
+        case 0:
+            record.Time = value;
+            break;
+        case 1:
+            record.Tote = static_cast<uint64_t>(value);
+            break;
+        case 2:
+            record.Line = static_cast<uint32_t>(value);
+            break;
+        case 3:
+            record.Conveyor = static_cast<uint16_t>(value);
+            break;
+        default:
+            record.Type = static_cast<RecordType>(value);
+            break;
+        }
+    }
+
+    void WriteVarint(std::vector<uint8_t>& bytes, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            bytes.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<uint8_t>(value));
+    }
+
+    bool ReadVarint(const uint8_t*& position, const uint8_t* end, uint64_t& value)
+    {
+        value = 0;
+        for (uint32_t shift = 0; position < end && shift < 64; shift += 7)
+        {
+            const uint8_t byte = *position++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint64_t ZigZagEncode(int64_t value)
+    {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    int64_t ZigZagDecode(uint64_t value)
+    {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    void WriteUint32(std::ofstream& file, uint32_t value)
+    {
+        const uint8_t bytes[4] = {
+            static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value >> 16),
+            static_cast<uint8_t>(value >> 24)};
+        file.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    }
+
+    bool ReadUint32(std::ifstream& file, uint32_t& value)
+    {
+        uint8_t bytes[4];
+        if (!file.read(reinterpret_cast<char*>(bytes), sizeof(bytes)))
+        {
+            return false;
+        }
+        value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+        return true;
+    }
+} // namespace
+
+namespace WealthOfRows::ToteLog
+{
+    Writer::~Writer()
+    {
+        Close();
+    }
+
+    bool Writer::Open(const std::string& path, size_t producerCount, uint64_t queueCapacity)
+    {
+        File.open(path, std::ios::binary | std::ios::trunc);
+        if (!File)
+        {
+            Ers::Logger::Info(std::format("[Tote log] Could not create {}", path));
+            return false;
+        }
+        File.write(FileMagic, sizeof(FileMagic));
+
+        Producers.clear();
+        for (size_t i = 0; i < producerCount; i++)
+        {
+            Producers.push_back(std::make_unique<Producer>(queueCapacity));
+        }
+
+        // Sized once, so the writer thread does not allocate per block
+        Block.reserve(BlockSize);
+        for (auto& column : Columns)
+        {
+            column.reserve(BlockSize * 2);
+        }
+
+        Written = 0;
+        Stopping.store(false, std::memory_order_relaxed);
+        Thread = std::thread(&Writer::Run, this);
+        return true;
+    }
+
+    void Writer::Close()
+    {
+        if (!Thread.joinable())
+        {
+            return;
+        }
+
+        Stopping.store(true, std::memory_order_release);
+        Thread.join();
+        File.close();
+    }
+
+    uint64_t Writer::DroppedRecords() const
+    {
+        uint64_t dropped = 0;
+        for (const auto& producer : Producers)
+        {
+            dropped += producer->Dropped.load(std::memory_order_relaxed);
+        }
+        return dropped;
+    }
+
+    void Writer::Run()
+    {
+        while (true)
+        {
+            // Read before draining, so the last pass after Close still empties every queue
+            const bool stopping = Stopping.load(std::memory_order_acquire);
+
+            uint64_t drained = 0;
+            for (auto& producer : Producers)
+            {
+                // Bounded by the capacity, so a busy producer can't starve the others
+                Record record;
+                for (uint64_t i = 0; i < producer->Queue.Capacity() && producer->Queue.TryPop(record); i++)
+                {
+                    Block.push_back(record);
+                    if (Block.size() == BlockSize)
+                    {
+                        FlushBlock();
+                    }
+                    drained++;
+                }
+            }
+
+            if (drained == 0)
+            {
+                if (stopping)
+                {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        FlushBlock();
+    }
+
+    void Writer::FlushBlock()
+    {
+        if (Block.empty())
+        {
+            return;
+        }
+
+        for (size_t column = 0; column < ColumnCount; column++)
+        {
+            std::vector<uint8_t>& bytes = Columns[column];
+            bytes.clear();
+
+            int64_t previous = 0;
+            for (const Record& record : Block)
+            {
+                const int64_t value = ColumnValue(record, column);
+                WriteVarint(bytes, ZigZagEncode(value - previous));
+                previous = value;
+            }
+        }
+
+        WriteUint32(File, static_cast<uint32_t>(Block.size()));
+        for (const auto& column : Columns)
+        {
+            WriteUint32(File, static_cast<uint32_t>(column.size()));
+        }
+        for (const auto& column : Columns)
+        {
+            File.write(reinterpret_cast<const char*>(column.data()), static_cast<std::streamsize>(column.size()));
+        }
+
+        Written += Block.size();
+        Block.clear();
+    }
+
+    bool ReadFile(const std::string& path, const std::function<void(const Record&)>& visit)
+    {
+        std::ifstream file(path, std::ios::binary);
+        char magic[sizeof(FileMagic)];
+        if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), FileMagic))
+        {
+            Ers::Logger::Info(std::format("[Tote log] {} is not a tote log", path));
+            return false;
+        }
+
+        std::vector<Record> block;
+        std::vector<uint8_t> bytes;
+        uint32_t recordCount = 0;
+        while (ReadUint32(file, recordCount))
+        {
+            std::array<uint32_t, ColumnCount> columnSizes;
+            for (uint32_t& columnSize : columnSizes)
+            {
+                if (!ReadUint32(file, columnSize))
+                {
+                    return false;
+                }
+            }
+
+            block.assign(recordCount, Record{});
+            for (size_t column = 0; column < ColumnCount; column++)
+            {
+                bytes.resize(columnSizes[column]);
+                if (!file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())))
+                {
+                    return false;
+                }
+
+                const uint8_t* position = bytes.data();
+                const uint8_t* end      = position + bytes.size();
+                int64_t value           = 0;
+                for (Record& record : block)
+                {
+                    uint64_t encoded = 0;
+                    if (!ReadVarint(position, end, encoded))
+                    {
+                        return false;
+                    }
+                    value += ZigZagDecode(encoded);
+                    SetColumnValue(record, column, value);
+                }
+            }
+
+            for (const Record& record : block)
+            {
+                visit(record);
+            }
+        }
+
+        return true;
+    }
+
+    bool SummarizeSojournTimes(
+        const std::string& path, uint32_t lineCount, uint16_t lastConveyor, int64_t precision, SojournSummary& summary)
+    {
+        // The line side and the sink side of a tote are written by different producers, so either side can be ahead in the file
+        struct ToteTimes
+        {
+            int64_t Created{0};
+            int64_t LeftLine{0};
+            int64_t Received{0};
+            int64_t Joined{0};
+            uint8_t Seen{0};
+        };
+
+        constexpr uint8_t SeenCreated  = 1 << 0;
+        constexpr uint8_t SeenLeftLine = 1 << 1;
+        constexpr uint8_t SeenReceived = 1 << 2;
+        constexpr uint8_t SeenJoined   = 1 << 3;
+        constexpr uint8_t SeenAll      = SeenCreated | SeenLeftLine | SeenReceived | SeenJoined;
+
+        std::vector<std::unordered_map<uint64_t, ToteTimes>> lines(lineCount);
+
+        // The entry time of a tote on a conveyor, until it exits. Both records of a conveyor are written by the producer of its chunk,
+        // in order, but the records of the next conveyor can be in another chunk and be read first, so the entries are kept per
+        // conveyor. Keyed by the tote in the upper bits and the conveyor in the lower 16 bits.
+        std::vector<std::unordered_map<uint64_t, int64_t>> enteredTimes(lineCount);
+        std::vector<int64_t> timeOnConveyor(lastConveyor + 1, 0);
+        std::vector<uint64_t> totesOnConveyor(lastConveyor + 1, 0);
+        int64_t timeInLine   = 0;
+        uint64_t totesInLine = 0;
+        int64_t waitAtSink   = 0;
+        uint64_t totesAtSink = 0;
+        int64_t totalTime    = 0;
+
+        summary = SojournSummary{};
+
+        const bool read = ReadFile(
+            path,
+            [&](const Record& record)
+            {
+                summary.Records++;
+                if (record.Line >= lineCount || record.Conveyor > lastConveyor)
+                {
+                    return;
+                }
+
+                const uint64_t onConveyor = (record.Tote << 16) | record.Conveyor;
+                if (record.Type == RecordType::Entered)
+                {
+                    enteredTimes[record.Line][onConveyor] = record.Time;
+                    return;
+                }
+                if (record.Type == RecordType::Exited)
+                {
+                    auto& entered            = enteredTimes[record.Line];
+                    const auto enteredRecord = entered.find(onConveyor);
+                    if (enteredRecord != entered.end())
+                    {
+                        timeOnConveyor[record.Conveyor] += record.Time - enteredRecord->second;
+                        totesOnConveyor[record.Conveyor]++;
+                        entered.erase(enteredRecord);
+                    }
+
+                    // Only leaving the line is part of the sojourn times of the tote
+                    if (record.Conveyor != lastConveyor)
+                    {
+                        return;
+                    }
+                }
+
+                auto& totes       = lines[record.Line];
+                ToteTimes& tote   = totes[record.Tote];
+                const uint8_t was = tote.Seen;
+                switch (record.Type)
+                {
+                case RecordType::Created:
+                    tote.Created = record.Time;
+                    tote.Seen |= SeenCreated;
+                    break;
+                case RecordType::Entered:
+                    // Paired per conveyor above
+                    break;
+                case RecordType::Exited:
+                    tote.LeftLine = record.Time;
+                    tote.Seen |= SeenLeftLine;
+                    break;
+                case RecordType::Received:
+                    tote.Received = record.Time;
+                    tote.Seen |= SeenReceived;
+                    break;
+                case RecordType::Joined:
+                    tote.Joined = record.Time;
+                    tote.Seen |= SeenJoined;
+                    break;
+                }
+
+                // Every sojourn time is added once both of its records have been read
+                auto completes = [&](uint8_t pair) { return (was & pair) != pair && (tote.Seen & pair) == pair; };
+                if (completes(SeenCreated | SeenLeftLine))
+                {
+                    timeInLine += tote.LeftLine - tote.Created;
+                    totesInLine++;
+                }
+                if (completes(SeenReceived | SeenJoined))
+                {
+                    waitAtSink += tote.Joined - tote.Received;
+                    totesAtSink++;
+                }
+                if (completes(SeenCreated | SeenJoined))
+                {
+                    totalTime += tote.Joined - tote.Created;
+                    summary.JoinedTotes++;
+                }
+
+                if (tote.Seen == SeenAll)
+                {
+                    totes.erase(record.Tote);
+                }
+            });
+
+        auto meanSeconds = [precision](int64_t time, uint64_t count)
+        { return count == 0 ? 0.0 : static_cast<double>(time) / static_cast<double>(count) / static_cast<double>(precision); };
+
+        summary.MeanTimeInLine = meanSeconds(timeInLine, totesInLine);
+        summary.MeanWaitAtSink = meanSeconds(waitAtSink, totesAtSink);
+        summary.MeanTotalTime  = meanSeconds(totalTime, summary.JoinedTotes);
+        for (size_t conveyor = 0; conveyor < timeOnConveyor.size(); conveyor++)
+        {
+            summary.MeanTimeOnConveyor.push_back(meanSeconds(timeOnConveyor[conveyor], totesOnConveyor[conveyor]));
+        }
+
+        return read;
+    }
+} // namespace WealthOfRows::ToteLog
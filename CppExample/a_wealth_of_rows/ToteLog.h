@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SpscQueue.h"
+
+// Per-tote lifecycle log. Every simulator pushes fixed-size records into its own lock-free queue, a writer thread drains the
+// queues into a compressed columnar file. A simulator never waits for the writer, a record that does not fit is dropped and counted.
+namespace WealthOfRows::ToteLog
+{
+    enum class RecordType : uint8_t
+    {
+        // A source created the tote
+        Created,
+        // The tote entered a conveyor
+        Entered,
+        // The tote left a conveyor
+        Exited,
+        // The sink received the tote from its line
+        Received,
+        // The sink that received the tote joined it with a tote of each of its other lines. With aggregators that is the aggregator
+        // of the line, which forwards the joined group towards the final simulator.
+        Joined,
+    };
+
+    // Highest conveyor index a record can hold
+    constexpr uint64_t MaximumConveyor = UINT16_MAX;
+
+    struct Record
+    {
+        // Simulation time relative to the start of the run, in units of the model precision
+        int64_t Time;
+        // ID of the tote in its line, the same in every record of the tote
+        uint64_t Tote;
+        uint32_t Line;
+        uint16_t Conveyor;
+        RecordType Type;
+    };
+
+    // The queue of a single simulator, only that simulator pushes and only the writer thread pops
+    struct Producer
+    {
+        explicit Producer(uint64_t capacity) : Queue(capacity) {}
+
+        void Push(const Record& record)
+        {
+            if (!Queue.TryPush(record))
+            {
+                // Only this producer writes the counter, the writer thread reads it
+                Dropped.store(Dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+        }
+
+        SpscQueue<Record> Queue;
+        std::atomic<uint64_t> Dropped{0};
+    };
+
+    class Writer
+    {
+      public:
+        static constexpr uint64_t DefaultQueueCapacity = 1 << 14;
+
+        Writer() = default;
+        ~Writer();
+
+        Writer(const Writer&)            = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        // Creates the file and a queue for each producer, and starts the writer thread
+        bool Open(const std::string& path, size_t producerCount, uint64_t queueCapacity = DefaultQueueCapacity);
+
+        // Writes the records still in the queues and stops the writer thread, the producers must have stopped pushing
+        void Close();
+
+        bool IsOpen() const { return Thread.joinable(); }
+
+        Producer& GetProducer(size_t index) { return *Producers.at(index); }
+
+        uint64_t WrittenRecords() const { return Written; }
+        uint64_t DroppedRecords() const;
+
+      private:
+        void Run();
+        void FlushBlock();
+
+        std::ofstream File;
+        std::vector<std::unique_ptr<Producer>> Producers;
+        std::thread Thread;
+        std::atomic<bool> Stopping{false};
+
+        // Only used by the writer thread
+        std::vector<Record> Block;
+        std::array<std::vector<uint8_t>, 5> Columns;
+        uint64_t Written{0};
+    };
+
+    // Calls visit for every record in a file written by Writer, in file order. The records of a single producer keep their order.
+    bool ReadFile(const std::string& path, const std::function<void(const Record&)>& visit);
+
+    // Sojourn times of the totes in a log, in seconds of simulation time
+    struct SojournSummary
+    {
+        uint64_t Records{0};
+        uint64_t JoinedTotes{0};
+
+        double MeanTimeInLine{0.0};
+        double MeanWaitAtSink{0.0};
+        double MeanTotalTime{0.0};
+
+        // Mean time a tote spent on each conveyor, indexed by conveyor
+        std::vector<double> MeanTimeOnConveyor;
+    };
+
+    // The records of a tote are paired by its line and ID, whichever producer wrote them, and its entry and exit of a conveyor by the
+    // conveyor too. A dropped record leaves its tote without a pair, so the summary is only valid when the writer dropped no records.
+    bool SummarizeSojournTimes(
+        const std::string& path, uint32_t lineCount, uint16_t lastConveyor, int64_t precision, SojournSummary& summary);
+} // namespace WealthOfRows::ToteLog
@@ -1,9 +1,16 @@
+#include <algorithm>
+#include <cassert>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <format>
+#include <functional>
 #include <iostream>
-#include <queue>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include "Ers/Api.h"
 #include "Ers/Debugging/Debugger.h"
@@ -29,6 +36,14 @@
 #include "Ers/External/ImPlotCpp.hpp"
 #include "Ers/Logger.h"
 
+#include "AllocationAudit.h"
+#include "LookaheadPromise.h"
+#include "MetricsReporter.h"
+#include "RandomStream.h"
+#include "RingBuffer.h"
+#include "TimeSteppedLine.h"
+#include "ToteLog.h"
+
 #ifdef WOR_DEBUGGER
 #include "Ers/Systems/RenderSystem.h"
 #endif
@@ -45,15 +60,72 @@ namespace WealthOfRows
 
     inline DebugUiState g_DebugUiState{};
 
-    // Forward declaration
-    class ConveyorScriptBehavior;
+    // How totes are represented while they travel through the conveyor lines
+    enum class ToteMode
+    {
+        // Every tote is an entity, moved with UpdateParentOnEntity and SendEntity/ReceiveEntity
+        Entity,
+        // Every tote is a plain integer ID, moved between the ring buffers of the conveyors directly
+        Lightweight,
+    };
+
+    // Delay of the sync event that carries a tote from the end of its line to the final simulator, in seconds
+    constexpr SimulationTime SinkSyncDelay = 1;
+
+    // Clock and tote log of a submodel. The clock is the due time of the event that is being processed, relative to the start of
+    // the run, every event of the model carries its due time for this.
+    struct ToteLogContext
+    {
+        SimulationTime Now{0};
+        uint32_t Line{0};
+
+        // Index in the whole line of the first conveyor of the submodel, see SubModelStatistics::FirstConveyorIndex
+        uint64_t FirstConveyor{0};
+
+        // Only set while a tote log is attached to the model, see AttachToteLog
+        ToteLog::Producer* Producer{nullptr};
+
+        // Sets the clock to the time of the event being handled
+        void Advance(SimulationTime time) { Now = time; }
+
+        void Log(ToteLog::RecordType type, uint32_t line, uint64_t conveyor, uint64_t tote)
+        {
+            if (Producer != nullptr)
+            {
+                // A log is only attached when every conveyor fits in a record, see CanLogTotes
+                assert(conveyor <= ToteLog::MaximumConveyor);
+                Producer->Push({Now, tote, line, static_cast<uint16_t>(conveyor), type});
+            }
+        }
+    };
+
+    // Counts an event in the metrics of the simulator that handles it, only while the model reports metrics, see RunModel.
+    // Every event handler calls it first, so events that are ignored after a reset and stale wake-ups are counted too.
+    inline void CountEvent(Ers::SubModel& submodel, SimulationTime time)
+    {
+        if (auto* metrics = submodel.GetSubModelContext<ErsExamples::MetricsContext>().Metrics)
+        {
+            metrics->CountEvent(time);
+        }
+    }
+
     class SubModelStatistics : public Ers::ScriptBehaviorComponent
     {
       public:
         SubModelStatistics() :
             NumberOfGeneratedEntities(0),
             NumberOfMovedEntities(0),
-            HasStartedInitialization(false)
+            HasStartedInitialization(false),
+            LightweightTotes(false),
+            SinkSimulatorID(0),
+            Generation(0),
+            LineIndex(0),
+            FirstConveyorIndex(0),
+            ReceivesFromChunk(false),
+            SendsToChunk(false),
+            PreviousChunkSimulatorID(0),
+            Credits(0),
+            ChunkSyncDelay(1)
         {
         }
 
@@ -64,19 +136,74 @@ namespace WealthOfRows
         uint64_t NumberOfMovedEntities;
         std::vector<EntityID> Conveyors;
         bool HasStartedInitialization;
+        bool LightweightTotes;
+
+        // The final simulator, or the aggregator in front of it that joins this line. Set when the model builder adds the dependency,
+        // so sending a tote does not look up the dependency by name.
+        uint32_t SinkSimulatorID;
+
+        // Incremented by every reset of the model, see ResetModel
+        uint64_t Generation;
+
+        // A long line can be split into chunks of consecutive conveyors, each in its own simulator. Conveyor c of a chunk is
+        // conveyor FirstConveyorIndex + c of the whole line.
+        uint64_t LineIndex;
+        uint64_t FirstConveyorIndex;
+
+        // The first conveyor of every chunk after the first is an inbox for the totes of the previous chunk, instead of a source.
+        // The last conveyor of every chunk before the last hands its totes to the next chunk, SinkSimulatorID, instead of the sink.
+        bool ReceivesFromChunk;
+        bool SendsToChunk;
+        uint32_t PreviousChunkSimulatorID;
+
+        // Totes the last conveyor may still hand to the next chunk. Every hand-off takes one, and the next chunk returns one
+        // whenever a tote leaves its first conveyor, so the inbox and that conveyor never hold more than its capacity together.
+        uint64_t Credits;
+
+        // Delay of the sync events between chunks
+        SimulationTime ChunkSyncDelay;
 
         static const char* StatisticsEntityName;
     };
 
+    // Joins one tote of every line at a time. The final simulator has a sink, and so does every aggregator in front of it, which
+    // joins the lines of its inputs and forwards each joined group to the next sink instead of counting it.
     struct SinkPropertiesComponent : public Ers::ScriptBehaviorComponent
     {
 
         uint64_t ReceivedTotes{0};
-        std::vector<std::queue<EntityID>> IncomingQueues;
+        std::vector<RingBuffer<EntityID>> IncomingQueues;
+
+        // The IDs of the totes in IncomingQueues in the tote log, only kept when the inputs are lines
+        std::vector<RingBuffer<EntityID>> IncomingLineTotes;
+
+        // Lines that feed the sink, directly or through aggregators. A join takes one tote of each.
+        uint64_t LineCount{0};
+
+        // The inputs are lines instead of aggregators, so the queues hold the totes themselves instead of joined groups
+        bool ReceivesLineTotes{true};
+
+        // The inputs of a sink are added one after the other, so the queue of an input is its simulator ID minus this
+        uint32_t FirstIncomingSimulatorID{0};
+
+        // Index of the line of the first input, only set when the inputs are lines
+        uint32_t FirstLineIndex{0};
+
+        // Only set on the sink of an aggregator
+        bool Forwards{false};
+        uint32_t ForwardSimulatorID{0};
+
+        // Incremented by every reset of the model, totes sent in an older generation are dropped
+        uint64_t Generation{0};
 
         bool operator==(const SinkPropertiesComponent& other) const { return this == &other; }
 
         void Serialization(Ers::Serializer node) override;
+
+        // Queues a tote or joined group that arrived from an input, and joins the oldest of every input once all inputs have one.
+        // lineTote is the ID of a tote in the tote log.
+        template <ToteMode Mode>
+        void Receive(Ers::SubModel& submodel, uint32_t senderSimulatorId, EntityID arrival, EntityID lineTote);
     };
 
     struct ConveyorPropertiesComponent : public Ers::DataComponent
@@ -87,6 +214,8 @@ namespace WealthOfRows
         uint64_t ChanceOfDelay{0};
         uint64_t DelayTimeMin{1};
         uint64_t DelayTimeMax{10};
+
+        // Whether the conveyor has a ready tote, the first conveyor is always allowed to move out
         bool AllowedToMoveOut{false};
 
         uint64_t ConveyorIndex{0};
@@ -117,11 +246,80 @@ namespace WealthOfRows
         }
     };
 
-    class ConveyorScriptBehavior : public Ers::ScriptBehaviorComponent
+    // Identifies a tote entity in the tote log by its ID in the line, the number of totes the line generated before it, like a
+    // lightweight tote. Entity IDs are reused once a tote has left its line. Only added while a tote log is attached.
+    struct ToteIdentityComponent : public Ers::DataComponent
+    {
+        uint64_t LineTote{0};
+
+        bool operator==(const ToteIdentityComponent& other) const { return this == &other; }
+
+        static Ers::TypeInfo* GetTypeInfo()
+        {
+            Ers::TypeInfo* toteIdentityTypeInfo = Ers::TypeInfo::RegisterStruct("tote_identity");
+            toteIdentityTypeInfo->AddField("line_tote", Ers::FieldType::Int64, offsetof(ToteIdentityComponent, LineTote));
+            return toteIdentityTypeInfo;
+        }
+    };
+
+    // ID of tote in the tote log, see ToteIdentityComponent
+    template <ToteMode Mode>
+    EntityID LineToteOf(Ers::SubModel& submodel, EntityID tote)
+    {
+        if constexpr (Mode == ToteMode::Entity)
+        {
+            if (submodel.HasComponent<ToteIdentityComponent>(tote))
+            {
+                return submodel.GetComponent<ToteIdentityComponent>(tote)->LineTote;
+            }
+        }
+        return tote;
+    }
+
+    // Position of a conveyor within its line, used to pick a specialized conveyor behavior
+    enum class ConveyorRole
+    {
+        // Decides at runtime from the conveyor index and the line length what the conveyor does
+        Generic,
+        // First conveyor of a line, generates totes and passes them on without delay
+        Source,
+        // Conveyor between the source and the final conveyor
+        Intermediate,
+        // Last conveyor of a line, sends its totes to the final simulator
+        Final,
+    };
+
+    // Compile-time description of a conveyor behavior, deterministic conveyors never draw a random delay. A source never draws one,
+    // it is deterministic when the rest of its line is, so that every behavior of a line finds its neighbours by the same variant.
+    template <ConveyorRole RoleValue, bool DeterministicValue = false>
+    struct ConveyorPolicy
+    {
+        static constexpr ConveyorRole Role  = RoleValue;
+        static constexpr bool Deterministic = DeterministicValue;
+    };
+
+    using GenericConveyorPolicy = ConveyorPolicy<ConveyorRole::Generic>;
+
+    template <ToteMode Mode, typename Policy = GenericConveyorPolicy>
+    class BasicConveyorScriptBehavior;
+
+    using ConveyorScriptBehavior            = BasicConveyorScriptBehavior<ToteMode::Entity>;
+    using LightweightConveyorScriptBehavior = BasicConveyorScriptBehavior<ToteMode::Lightweight>;
+
+    // Specialized behaviors, the model builder only uses these when a line has a separate source and final conveyor
+    template <ToteMode Mode, bool Deterministic>
+    using SourceConveyorScriptBehavior = BasicConveyorScriptBehavior<Mode, ConveyorPolicy<ConveyorRole::Source, Deterministic>>;
+    template <ToteMode Mode, bool Deterministic>
+    using IntermediateConveyorScriptBehavior = BasicConveyorScriptBehavior<Mode, ConveyorPolicy<ConveyorRole::Intermediate, Deterministic>>;
+    template <ToteMode Mode, bool Deterministic>
+    using FinalConveyorScriptBehavior = BasicConveyorScriptBehavior<Mode, ConveyorPolicy<ConveyorRole::Final, Deterministic>>;
+
+    template <ToteMode Mode, typename Policy>
+    class BasicConveyorScriptBehavior : public Ers::ScriptBehaviorComponent
     {
 
       public:
-        ConveyorScriptBehavior();
+        BasicConveyorScriptBehavior();
 
         void OnAwake() override;
         void OnDestroy() override;
@@ -129,47 +327,208 @@ namespace WealthOfRows
         void OnStart() override;
         void CreateToteEvent();
 
+        // In entity mode these are fired by UpdateParentOnEntity, in lightweight mode the conveyors call them directly
         void OnEntered(EntityID newChild) override;
         void OnExited(EntityID oldChild) override;
 
         void Serialization(Ers::Serializer node) override;
 
-        // Contains all entities currently present in this conveyor
-        std::queue<EntityID> ToteQueue;
+        // Contains all totes currently present in this conveyor, its size is the child count of the conveyor
+        RingBuffer<EntityID> ToteQueue;
+
+        // The totes that are done on this conveyor and wait for room on the next one, in the order they became ready. Only these may
+        // move out: with a capacity above one, the first tote on the conveyor can still be on its way while a later one is ready.
+        RingBuffer<EntityID> ReadyTotes;
 
         void DelayOrMove(const EntityID& primedTote);
-        void MoveRequest(const EntityID& primedTote);
+
+        // Moves the first ready tote out of the conveyor when there is room for it
+        void MoveRequest();
+
+        // Removes all totes from the conveyor and makes it ignore the events that were scheduled before the reset
+        void Reset(uint64_t generation);
+
+        // Generation of the model this conveyor runs in, events carry the generation they were scheduled in
+        uint64_t Generation{0};
+
+        void SeedRandomStreams(uint64_t seed, uint64_t lineIndex, uint64_t conveyorIndex);
+
+        // Only the source draws tote arrivals, only the other conveyors draw delays
+        RandomStream ToteArrivalStream;
+        RandomStream DelayChanceStream;
+        RandomStream DelayLengthStream;
+
+        // A tote that is due for DelayOrMove, ties are ordered by the sequence so totes due at the same time keep their order
+        struct DueTote
+        {
+            SimulationTime Time;
+            uint64_t Sequence;
+            EntityID Tote;
+
+            bool operator>(const DueTote& other) const
+            {
+                return Time != other.Time ? Time > other.Time : Sequence > other.Sequence;
+            }
+        };
+
+        static constexpr SimulationTime NoWakeUp = -1;
+
+        // With bundled events the conveyor keeps its due totes in a min-heap and has a single live wake-up event for the earliest one,
+        // instead of an event for every tote. Without, every tote gets its own TriggerDelayOrMoveEvent.
+        bool BundleEvents{true};
+        std::vector<DueTote> DueTotes;
+        uint64_t DueToteSequence{0};
+
+        // Due time of the wake-up event that is still valid. An earlier tote makes the pending wake-up event stale, it stays in the
+        // queue until its time and is ignored then, so the stale events are not bounded by a constant
+        SimulationTime WakeUpTime{NoWakeUp};
+
+        // Processes every tote that is due by now and schedules the wake-up event for the next due tote
+        void WakeUp();
+
+        // Events of this conveyor, stale wake-up events are counted until they are processed, so the peak includes them
+        uint64_t ScheduledEvents{0};
+        uint64_t PendingEvents{0};
+        uint64_t PeakPendingEvents{0};
+
+        void OnEventProcessed() { PendingEvents--; }
+
+        // Called on the last conveyor of a chunk when the next chunk returned a credit, the first tote may be handed off now
+        void OnCreditReturned(SubModelStatistics* statistics);
+
+        // Only set on the last conveyor of a chunk with automatic promises, its occupancy tells when it can send its next tote
+        bool PromisesToSink{false};
+        ErsExamples::LookaheadPromise SinkPromise;
+
+      private:
+        static constexpr bool IsGeneric = Policy::Role == ConveyorRole::Generic;
+        static constexpr bool IsSource  = Policy::Role == ConveyorRole::Source;
+        static constexpr bool IsFinal   = Policy::Role == ConveyorRole::Final;
+
+        // Constant for the specialized behaviors, so the branches on them compile away
+        static bool IsFirstConveyor(const ConveyorPropertiesComponent* properties);
+        static bool IsLastConveyor(const ConveyorPropertiesComponent* properties, const SubModelStatistics* statistics);
+
+        // The model builder only gives partitioned lines the generic behavior, so a specialized conveyor never borders another chunk
+        static bool SendsToChunk(const SubModelStatistics* statistics);
+        static bool ReceivesFromChunk(const SubModelStatistics* statistics);
+
+        // Calls function with the behavior of another conveyor in the same line. The type of the neighbours of a specialized
+        // conveyor follows from their index, since the model builder assigns the behaviors by position.
+        template <typename Function>
+        static void VisitConveyor(Ers::SubModel& submodel, const SubModelStatistics* statistics, uint64_t conveyorIndex, Function&& function);
+
+        static uint64_t ChildCount(Ers::SubModel& submodel, const SubModelStatistics* statistics, uint64_t conveyorIndex);
+        void MoveToConveyor(Ers::SubModel& submodel, const SubModelStatistics* statistics, uint64_t conveyorIndex, const EntityID& tote);
+        void MoveOutOfLine(Ers::SubModel& submodel, const EntityID& tote);
+
+        // Lets the previous conveyor move its first tote into this conveyor, now that this conveyor has room for it
+        static void NotifyPreviousConveyor(
+            Ers::SubModel& submodel, const SubModelStatistics* statistics, const ConveyorPropertiesComponent* properties);
+
+        void LogTote(Ers::SubModel& submodel, ToteLogContext& context, ToteLog::RecordType type, EntityID tote);
+
+        // Calls DelayOrMove for the tote after delay, through a wake-up of the conveyor or an event for the tote
+        void ScheduleDelayOrMove(const ToteLogContext& context, const EntityID& tote, SimulationTime delay);
+        void ScheduleWakeUp(const ToteLogContext& context, SimulationTime time);
+        void CountScheduledEvent();
+
+        // Promises the final simulator that no tote arrives before this conveyor can send its next one
+        void UpdateSinkPromise();
     };
 
-    // Event to trigger CreateToteEvent on ConveyorScriptBehavior
+    // Event to trigger CreateToteEvent on a conveyor behavior
+    template <typename Behavior>
     struct TriggerCreateToteEvent
     {
         EntityID entity;
+        uint64_t generation;
+        SimulationTime time;
 
         void OnEvent()
         {
+            AllocationAudit::EventScope auditScope(AllocationAudit::Event::CreateTote);
             auto& submodel = Ers::SubModel::Get();
-            auto* self     = submodel.GetComponent<ConveyorScriptBehavior>(entity);
+            CountEvent(submodel, time);
+            auto* self = submodel.GetComponent<Behavior>(entity);
+
+            // Scheduled before the model was reset
+            if (self->Generation != generation)
+            {
+                return;
+            }
+
+            submodel.GetSubModelContext<ToteLogContext>().Advance(time);
             self->CreateToteEvent();
         }
 
-        ERS_EVENT(entity)
+        ERS_EVENT(entity, generation, time)
     };
 
-    // Event to trigger DelayOrMove on ConveyorScriptBehavior
+    // Event to trigger DelayOrMove on a conveyor behavior
+    template <typename Behavior>
     struct TriggerDelayOrMoveEvent
     {
         EntityID entity;
         EntityID child;
+        uint64_t generation;
+        SimulationTime time;
 
         void OnEvent()
         {
+            AllocationAudit::EventScope auditScope(AllocationAudit::Event::DelayOrMove);
             auto& submodel = Ers::SubModel::Get();
-            auto* self     = submodel.GetComponent<ConveyorScriptBehavior>(entity);
+            CountEvent(submodel, time);
+            auto* self = submodel.GetComponent<Behavior>(entity);
+
+            // Scheduled before the model was reset
+            if (self->Generation != generation)
+            {
+                return;
+            }
+
+            self->OnEventProcessed();
+            submodel.GetSubModelContext<ToteLogContext>().Advance(time);
             self->DelayOrMove(child);
         }
 
-        ERS_EVENT(entity, child)
+        ERS_EVENT(entity, child, generation, time)
+    };
+
+    // Event to wake up a conveyor behavior with bundled events, see BasicConveyorScriptBehavior::WakeUp
+    template <typename Behavior>
+    struct TriggerWakeUpEvent
+    {
+        EntityID entity;
+        uint64_t generation;
+        SimulationTime time;
+
+        void OnEvent()
+        {
+            AllocationAudit::EventScope auditScope(AllocationAudit::Event::DelayOrMove);
+            auto& submodel = Ers::SubModel::Get();
+            CountEvent(submodel, time);
+            auto* self = submodel.GetComponent<Behavior>(entity);
+
+            // Scheduled before the model was reset
+            if (self->Generation != generation)
+            {
+                return;
+            }
+
+            self->OnEventProcessed();
+
+            // Replaced by a wake-up for an earlier tote
+            if (self->WakeUpTime != time)
+            {
+                return;
+            }
+
+            submodel.GetSubModelContext<ToteLogContext>().Advance(time);
+            self->WakeUp();
+        }
+
+        ERS_EVENT(entity, generation, time)
     };
 
     struct SinkContext
@@ -180,67 +539,233 @@ namespace WealthOfRows
         SinkContext() { SinkEntity = Ers::SubModel::Get().FindEntity("Sink"); }
     };
 
-    struct SendToFinalSubModelEventData : Ers::ISyncEvent<SendToFinalSubModelEventData>
+    template <ToteMode Mode>
+    struct SendToFinalSubModelEventData : Ers::ISyncEvent<SendToFinalSubModelEventData<Mode>>
     {
         EntityID PrimedTote;
+        uint64_t Generation;
+
+        // PrimedTote is replaced by the sent entity, the log identifies the tote by its ID in the line
+        EntityID LineTote;
+        SimulationTime Time;
 
-        static const char* GetName() { return "Move to final submodel"; }
+        static const char* GetName()
+        {
+            return Mode == ToteMode::Entity ? "Move to final submodel" : "Move lightweight tote to final submodel";
+        }
+
+        void OnSenderSide()
+        {
+            AllocationAudit::EventScope auditScope(AllocationAudit::Event::SendTote);
+            CountEvent(Ers::SubModel::Get(), Time);
 
-        void OnSenderSide() { PrimedTote = Ers::SubModel::Get().SendEntity(Ers::SyncEvent::GetSyncEventTarget(), PrimedTote).id; }
+            // Lightweight totes are only an ID, which is sent as is
+            if constexpr (Mode == ToteMode::Entity)
+            {
+                PrimedTote = Ers::SubModel::Get().SendEntity(Ers::SyncEvent::GetSyncEventTarget(), PrimedTote).id;
+            }
+        }
 
         void OnTargetSide()
         {
+            AllocationAudit::EventScope auditScope(AllocationAudit::Event::ReceiveTote);
+
             // Inside the event body we have entered the target's submodel
             auto& targetSubModel = Ers::SubModel::Get();
+            CountEvent(targetSubModel, Time);
 
             // Take entities out of the channel
-            const Ers::Entity finalSubModelTote =
-                targetSubModel.ReceiveEntity(Ers::SyncEvent::GetSyncEventSender(), Ers::SentEntity(PrimedTote));
+            EntityID finalSubModelTote = PrimedTote;
+            if constexpr (Mode == ToteMode::Entity)
+            {
+                finalSubModelTote = EntityID(targetSubModel.ReceiveEntity(Ers::SyncEvent::GetSyncEventSender(), Ers::SentEntity(PrimedTote)));
+            }
 
             auto& context          = targetSubModel.GetSubModelContext<SinkContext>();
             Ers::Entity sinkEntity = context.SinkEntity;
             auto* sinkProperties   = sinkEntity.GetComponent<WealthOfRows::SinkPropertiesComponent>();
 
-            // Add tote to collection
-            auto& queue = sinkProperties->IncomingQueues.at(
-                Ers::SyncEvent::GetSyncEventSender()); // This only works because we aren't adding and removing submodels and the
-                                                       // model is build in
-                                                       // a
-                                                       // specific  order. Otherwise a map is more suitable
-            const bool previouslyPresent = !queue.empty();
-            queue.emplace(finalSubModelTote);
-
-            if (previouslyPresent)
+            // Sent before the model was reset
+            if (Generation != sinkProperties->Generation)
             {
+                if constexpr (Mode == ToteMode::Entity)
+                {
+                    targetSubModel.DestroyEntity(finalSubModelTote);
+                }
                 return;
             }
 
-            for (const auto& receivedTotesCollection : sinkProperties->IncomingQueues)
+            // The lines of a sink are added one after the other, so the line follows from the ID of the sender
+            const uint32_t sender = Ers::SyncEvent::GetSyncEventSender();
+            const uint32_t line   = sinkProperties->FirstLineIndex + (sender - sinkProperties->FirstIncomingSimulatorID);
+            auto& toteLogContext  = targetSubModel.GetSubModelContext<ToteLogContext>();
+            toteLogContext.Advance(Time);
+            toteLogContext.Log(ToteLog::RecordType::Received, line, 0, LineTote);
+
+            sinkProperties->Receive<Mode>(targetSubModel, sender, finalSubModelTote, LineTote);
+        }
+
+        ERS_EVENT(PrimedTote, Generation, LineTote, Time)
+    };
+
+    struct LineContext
+    {
+        EntityID StatisticsEntity;
+
+        // Constructor for automatic initialization after loading
+        LineContext() { StatisticsEntity = Ers::SubModel::Get().FindEntity(SubModelStatistics::StatisticsEntityName); }
+    };
+
+    // Hands a tote from the last conveyor of a chunk to the inbox of the next chunk of the line
+    template <ToteMode Mode>
+    struct HandOffToteEventData : Ers::ISyncEvent<HandOffToteEventData<Mode>>
+    {
+        EntityID PrimedTote;
+        uint64_t Generation;
+
+        // PrimedTote is replaced by the sent entity, the next chunk logs the tote by its ID in the line, like the sink does
+        EntityID LineTote;
+        SimulationTime Time;
+
+        static const char* GetName() { return Mode == ToteMode::Entity ? "Hand off tote" : "Hand off lightweight tote"; }
+
+        void OnSenderSide()
+        {
+            AllocationAudit::EventScope auditScope(AllocationAudit::Event::SendTote);
+            CountEvent(Ers::SubModel::Get(), Time);
+            if constexpr (Mode == ToteMode::Entity)
             {
-                if (receivedTotesCollection.empty())
-                {
-                    return;
-                }
+                PrimedTote = Ers::SubModel::Get().SendEntity(Ers::SyncEvent::GetSyncEventTarget(), PrimedTote).id;
             }
+        }
 
-            sinkProperties->ReceivedTotes += sinkProperties->IncomingQueues.size();
-            for (auto& receivedTotesCollection : sinkProperties->IncomingQueues)
-            {
+        // Defined after the conveyor behaviors, which it enters the tote into
+        void OnTargetSide();
+
+        ERS_EVENT(PrimedTote, Generation, LineTote, Time)
+    };
+
+    // Returns a credit to the previous chunk of the line, see SubModelStatistics::Credits
+    struct ReturnCreditEventData : Ers::ISyncEvent<ReturnCreditEventData>
+    {
+        uint64_t Generation;
+        SimulationTime Time;
+
+        static const char* GetName() { return "Return credit"; }
+
+        void OnSenderSide() { CountEvent(Ers::SubModel::Get(), Time); }
+
+        // Defined after the conveyor behaviors, which it lets move again
+        void OnTargetSide();
 
-                targetSubModel.DestroyEntity(receivedTotesCollection.front());
-                receivedTotesCollection.pop();
+        ERS_EVENT(Generation, Time)
+    };
+
+    // Carries a group of totes that an aggregator joined, one of every line beneath it, to the next sink
+    struct ForwardJoinedGroupEventData : Ers::ISyncEvent<ForwardJoinedGroupEventData>
+    {
+        uint64_t Group;
+        uint64_t Generation;
+        SimulationTime Time;
+
+        static const char* GetName() { return "Forward joined group"; }
+
+        void OnSenderSide() { CountEvent(Ers::SubModel::Get(), Time); }
+
+        void OnTargetSide()
+        {
+            AllocationAudit::EventScope auditScope(AllocationAudit::Event::ReceiveTote);
+            auto& targetSubModel = Ers::SubModel::Get();
+            CountEvent(targetSubModel, Time);
+
+            Ers::Entity sinkEntity = targetSubModel.GetSubModelContext<SinkContext>().SinkEntity;
+            auto* sinkProperties   = sinkEntity.GetComponent<SinkPropertiesComponent>();
+
+            // Sent before the model was reset
+            if (Generation != sinkProperties->Generation)
+            {
+                return;
             }
-            return;
+
+            targetSubModel.GetSubModelContext<ToteLogContext>().Advance(Time);
+
+            // The group is not an entity, so the mode only matters for the sinks that receive line totes
+            sinkProperties->Receive<ToteMode::Lightweight>(targetSubModel, Ers::SyncEvent::GetSyncEventSender(), Group, Group);
         }
 
-        ERS_EVENT(PrimedTote)
+        ERS_EVENT(Group, Generation, Time)
     };
 
-    ConveyorScriptBehavior::ConveyorScriptBehavior()
+    template <ToteMode Mode>
+    void SinkPropertiesComponent::Receive(Ers::SubModel& submodel, uint32_t senderSimulatorId, EntityID arrival, EntityID lineTote)
+    {
+        const uint32_t input         = senderSimulatorId - FirstIncomingSimulatorID;
+        auto& queue                  = IncomingQueues.at(input);
+        const bool previouslyPresent = !queue.Empty();
+        queue.Push(arrival);
+        if (ReceivesLineTotes)
+        {
+            IncomingLineTotes.at(input).Push(lineTote);
+        }
+
+        if (previouslyPresent)
+        {
+            return;
+        }
+
+        for (const auto& receivedTotesCollection : IncomingQueues)
+        {
+            if (receivedTotesCollection.Empty())
+            {
+                return;
+            }
+        }
+
+        auto& toteLogContext = submodel.GetSubModelContext<ToteLogContext>();
+        const uint64_t group = ReceivedTotes / LineCount;
+        ReceivedTotes += LineCount;
+        if (Forwards)
+        {
+            const SimulationTime delay = SinkSyncDelay * submodel.GetModelPrecision();
+
+            ForwardJoinedGroupEventData groupData;
+            groupData.Group      = group;
+            groupData.Generation = Generation;
+            groupData.Time       = toteLogContext.Now + delay;
+            Ers::EventScheduler::ScheduleSyncEvent<ForwardJoinedGroupEventData>(delay, ForwardSimulatorID, groupData);
+        }
+        else if (auto* metrics = submodel.GetSubModelContext<ErsExamples::MetricsContext>().Metrics)
+        {
+            metrics->CountDelivered(LineCount);
+        }
+
+        // The sink that receives the totes of a line joins them, the aggregators further down the tree only see joined groups
+        if (ReceivesLineTotes)
+        {
+            for (uint32_t i = 0; i < IncomingLineTotes.size(); i++)
+            {
+                toteLogContext.Log(ToteLog::RecordType::Joined, FirstLineIndex + i, 0, IncomingLineTotes[i].Front());
+                IncomingLineTotes[i].Pop();
+            }
+        }
+
+        for (auto& receivedTotesCollection : IncomingQueues)
+        {
+            if constexpr (Mode == ToteMode::Entity)
+            {
+                submodel.DestroyEntity(receivedTotesCollection.Front());
+            }
+            receivedTotesCollection.Pop();
+        }
+    }
+
+    template <ToteMode Mode, typename Policy>
+    BasicConveyorScriptBehavior<Mode, Policy>::BasicConveyorScriptBehavior()
     {
     }
 
-    void ConveyorScriptBehavior::OnAwake()
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::OnAwake()
     {
         auto& submodel = Ers::SubModel::Get();
 
@@ -249,200 +774,703 @@ namespace WealthOfRows
         // Resolve and cache the statistics entity reference
         // This works for both model creation and loading, since StatisticsEntity is not serialized
         properties->StatisticsEntity = submodel.FindEntity(SubModelStatistics::StatisticsEntityName);
+
+        // Size the ring buffer and the due totes for the capacity up front, so moving totes does not allocate while the model runs
+        ToteQueue.Reserve(std::max<uint64_t>(properties->Capacity, 1));
+        ReadyTotes.Reserve(std::max<uint64_t>(properties->Capacity, 1));
+        DueTotes.reserve(std::max<uint64_t>(properties->Capacity, 1));
     }
 
-    void ConveyorScriptBehavior::OnDestroy()
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::OnDestroy()
     {
     }
 
-    void ConveyorScriptBehavior::OnStart()
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::OnStart()
     {
     }
 
-    void ConveyorScriptBehavior::CreateToteEvent()
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::CreateToteEvent()
     {
         auto& submodel  = Ers::SubModel::Get();
         auto properties = submodel.GetComponent<ConveyorPropertiesComponent>(ConnectedEntity);
+        auto statistics = submodel.GetComponent<SubModelStatistics>(properties->StatisticsEntity);
 
-        const EntityID tote = submodel.CreateEntity("");
+        auto& toteLogContext = submodel.GetSubModelContext<ToteLogContext>();
+
+        // Lightweight totes are numbered by their generation order within the submodel
+        EntityID tote = statistics->NumberOfGeneratedEntities;
+        if constexpr (Mode == ToteMode::Entity)
+        {
+            const EntityID lineTote = tote;
+            tote                    = submodel.CreateEntity("");
+            if (toteLogContext.Producer != nullptr)
+            {
+                submodel.AddComponent<ToteIdentityComponent>(tote)->LineTote = lineTote;
+            }
+        }
 
-        auto& sm        = Ers::SubModel::Get();
-        auto statistics = submodel.GetComponent<SubModelStatistics>(properties->StatisticsEntity);
         statistics->NumberOfGeneratedEntities++;
 
-        submodel.UpdateParentOnEntity(tote, ConnectedEntity);
+        LogTote(submodel, toteLogContext, ToteLog::RecordType::Created, tote);
+
+        if constexpr (Mode == ToteMode::Entity)
+        {
+            submodel.UpdateParentOnEntity(tote, ConnectedEntity);
+        }
+        else
+        {
+            OnEntered(tote);
+        }
 
         SimulationTime eventDelay =
-            std::round(submodel.SampleRandomGenerator() * static_cast<double>(1'000'000)) * submodel.GetModelPrecision();
+            std::round(ToteArrivalStream.Sample() * static_cast<double>(1'000'000)) * submodel.GetModelPrecision();
         eventDelay /= SimulationTime(100000);
 
-        Ers::EventScheduler::ScheduleLocalEvent(0, eventDelay, TriggerCreateToteEvent{ConnectedEntity});
+        Ers::EventScheduler::ScheduleLocalEvent(
+            0, eventDelay, TriggerCreateToteEvent<BasicConveyorScriptBehavior>{ConnectedEntity, Generation, toteLogContext.Now + eventDelay});
     }
 
-    void ConveyorScriptBehavior::OnEntered(EntityID newChild)
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::OnEntered(EntityID newChild)
     {
-        auto& submodel  = Ers::SubModel::Get();
-        auto properties = submodel.GetComponent<ConveyorPropertiesComponent>(ConnectedEntity);
+        ToteQueue.Push(newChild);
+
+        // The promise only changes when the conveyor stops being empty
+        if (PromisesToSink && ToteQueue.Size() == 1)
+        {
+            UpdateSinkPromise();
+        }
 
-        ToteQueue.emplace(newChild);
+        auto& submodel       = Ers::SubModel::Get();
+        auto& toteLogContext = submodel.GetSubModelContext<ToteLogContext>();
+        LogTote(submodel, toteLogContext, ToteLog::RecordType::Entered, newChild);
 
-        if (properties->ConveyorIndex != 0)
+        // The first conveyor passes its totes on without delay
+        if constexpr (IsSource)
+        {
+            ReadyTotes.Push(newChild);
+            MoveRequest();
+        }
+        else
         {
+            auto properties = submodel.GetComponent<ConveyorPropertiesComponent>(ConnectedEntity);
+
+            if (IsFirstConveyor(properties))
+            {
+                ReadyTotes.Push(newChild);
+                MoveRequest();
+                return;
+            }
+
             // add delay
             SimulationTime timespan = properties->MinimumTime * submodel.GetModelPrecision();
 
             // Schedule events to advance the totes in the queue
-            Ers::EventScheduler::ScheduleLocalEvent(0, timespan, TriggerDelayOrMoveEvent{ConnectedEntity, newChild});
-        }
-        else
-        {
-            MoveRequest(newChild);
+            ScheduleDelayOrMove(toteLogContext, newChild, timespan);
         }
     }
 
-    void ConveyorScriptBehavior::OnExited(EntityID oldChild)
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::OnExited(EntityID oldChild)
     {
-        auto& submodel = Ers::SubModel::Get();
-
-        auto properties = submodel.GetComponent<ConveyorPropertiesComponent>(ConnectedEntity);
+        // Totes can leave a conveyor with a capacity above one in another order than they entered, so the tote that left is removed
+        // instead of the first one. The ring buffer then always holds exactly the totes on the conveyor.
+        [[maybe_unused]] const bool wasOnConveyor = ToteQueue.Remove(oldChild);
+        assert(wasOnConveyor);
 
-        ToteQueue.pop();
+        auto& submodel = Ers::SubModel::Get();
+        LogTote(submodel, submodel.GetSubModelContext<ToteLogContext>(), ToteLog::RecordType::Exited, oldChild);
+    }
 
-        // This is an implicit check for sources
-        if (properties->Capacity > 1)
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::Serialization(Ers::Serializer node)
+    {
+        // Save/load the tote ring buffer field by field
+        node.Serialize("tote_slots", ToteQueue.Slots);
+        node.Serialize("tote_head", ToteQueue.Head);
+        node.Serialize("tote_count", ToteQueue.Count);
+        node.Serialize("ready_tote_slots", ReadyTotes.Slots);
+        node.Serialize("ready_tote_head", ReadyTotes.Head);
+        node.Serialize("ready_tote_count", ReadyTotes.Count);
+        node.Serialize("generation", Generation);
+
+        // Save/load the random streams, so a loaded model continues with the same random numbers
+        node.Serialize("tote_arrival_stream", ToteArrivalStream.State);
+        node.Serialize("delay_chance_stream", DelayChanceStream.State);
+        node.Serialize("delay_length_stream", DelayLengthStream.State);
+
+        // Save/load the due totes field by field, the count is read first when loading so the heap can be sized
+        node.Serialize("bundle_events", BundleEvents);
+        uint64_t dueToteCount = DueTotes.size();
+        node.Serialize("due_tote_count", dueToteCount);
+        DueTotes.resize(dueToteCount);
+        for (uint64_t i = 0; i < dueToteCount; i++)
         {
-            properties->AllowedToMoveOut = true;
+            node.Serialize(std::format("due_time_{}", i).c_str(), DueTotes[i].Time);
+            node.Serialize(std::format("due_sequence_{}", i).c_str(), DueTotes[i].Sequence);
+            node.Serialize(std::format("due_tote_{}", i).c_str(), DueTotes[i].Tote);
         }
+        node.Serialize("due_tote_sequence", DueToteSequence);
+        node.Serialize("wake_up_time", WakeUpTime);
+        node.Serialize("promises_to_sink", PromisesToSink);
     }
 
-    void ConveyorScriptBehavior::Serialization(Ers::Serializer node)
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::SeedRandomStreams(uint64_t seed, uint64_t lineIndex, uint64_t conveyorIndex)
     {
-        // Save/load tote queue using helper
-        node.Serialize("tote_queue", ToteQueue);
+        ToteArrivalStream = RandomStream::Create(seed, lineIndex, conveyorIndex, RandomPurpose::ToteArrival);
+        DelayChanceStream = RandomStream::Create(seed, lineIndex, conveyorIndex, RandomPurpose::DelayChance);
+        DelayLengthStream = RandomStream::Create(seed, lineIndex, conveyorIndex, RandomPurpose::DelayLength);
     }
 
-    void ConveyorScriptBehavior::DelayOrMove(const EntityID& primedTote)
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::Reset(uint64_t generation)
     {
         auto& submodel = Ers::SubModel::Get();
 
-        auto properties = submodel.GetComponent<ConveyorPropertiesComponent>(ConnectedEntity);
-
-        // Add randomized delay
-        if (submodel.SampleRandomGenerator() * 100.0 <= static_cast<double>(properties->ChanceOfDelay))
+        // OnExited removes the tote that left from the ring buffer, so the ring buffer holds exactly the totes on the conveyor and
+        // every iteration removes its first tote
+        for (uint64_t remaining = ToteQueue.Size(); remaining > 0; remaining--)
         {
-            SimulationTime randomDelay((submodel.SampleRandomGenerator() * 100000) / 100000);
-
-            randomDelay *= SimulationTime(properties->DelayTimeMax - properties->DelayTimeMin);
+            const EntityID tote = ToteQueue.Front();
+            MoveOutOfLine(submodel, tote);
+            if constexpr (Mode == ToteMode::Entity)
+            {
+                submodel.DestroyEntity(tote);
+            }
+        }
+        assert(ToteQueue.Empty());
 
-            SimulationTime delay(properties->DelayTimeMin);
-            delay += randomDelay;
-            delay *= submodel.GetModelPrecision();
+        ReadyTotes.Clear();
+        DueTotes.clear();
 
-            Ers::EventScheduler::ScheduleLocalEvent(0, delay, TriggerDelayOrMoveEvent{ConnectedEntity, primedTote});
-            return;
+        // The next run starts with an empty conveyor
+        if (PromisesToSink)
+        {
+            UpdateSinkPromise();
         }
+        WakeUpTime        = NoWakeUp;
+        ScheduledEvents   = 0;
+        PendingEvents     = 0;
+        PeakPendingEvents = 0;
+        SinkPromise       = ErsExamples::LookaheadPromise(SinkPromise.MinimumSyncDelay);
 
-        properties->AllowedToMoveOut = true;
-
-        MoveRequest(primedTote);
+        Generation = generation;
     }
 
-    void ConveyorScriptBehavior::MoveRequest(const EntityID& primedTote)
+    template <ToteMode Mode, typename Policy>
+    bool BasicConveyorScriptBehavior<Mode, Policy>::IsFirstConveyor(const ConveyorPropertiesComponent* properties)
     {
-        auto& submodel = Ers::SubModel::Get();
-
-        auto properties = submodel.GetComponent<ConveyorPropertiesComponent>(ConnectedEntity);
+        if constexpr (IsGeneric)
+        {
+            return properties->ConveyorIndex == 0;
+        }
+        else
+        {
+            return IsSource;
+        }
+    }
 
-        if (!properties->AllowedToMoveOut)
+    template <ToteMode Mode, typename Policy>
+    bool BasicConveyorScriptBehavior<Mode, Policy>::IsLastConveyor(
+        const ConveyorPropertiesComponent* properties, const SubModelStatistics* statistics)
+    {
+        if constexpr (IsGeneric)
         {
-            return;
+            return statistics->Conveyors.size() - 1 == properties->ConveyorIndex;
+        }
+        else
+        {
+            return IsFinal;
+        }
+    }
+
+    template <ToteMode Mode, typename Policy>
+    bool BasicConveyorScriptBehavior<Mode, Policy>::SendsToChunk(const SubModelStatistics* statistics)
+    {
+        if constexpr (IsGeneric)
+        {
+            return statistics->SendsToChunk;
         }
+        else
+        {
+            return false;
+        }
+    }
 
-        auto simulator       = submodel.GetSimulator();
-        uint32_t simulatorId = simulator.GetID();
+    template <ToteMode Mode, typename Policy>
+    bool BasicConveyorScriptBehavior<Mode, Policy>::ReceivesFromChunk(const SubModelStatistics* statistics)
+    {
+        if constexpr (IsGeneric)
+        {
+            return statistics->ReceivesFromChunk;
+        }
+        else
+        {
+            return false;
+        }
+    }
 
-        auto statistics = submodel.GetComponent<SubModelStatistics>(properties->StatisticsEntity);
+    template <ToteMode Mode, typename Policy>
+    template <typename Function>
+    void BasicConveyorScriptBehavior<Mode, Policy>::VisitConveyor(
+        Ers::SubModel& submodel, const SubModelStatistics* statistics, uint64_t conveyorIndex, Function&& function)
+    {
+        const EntityID& conveyor = statistics->Conveyors.at(conveyorIndex);
+        if constexpr (IsGeneric)
+        {
+            function(submodel.GetComponent<BasicConveyorScriptBehavior>(conveyor));
+        }
+        else if (conveyorIndex == 0)
+        {
+            function(submodel.GetComponent<SourceConveyorScriptBehavior<Mode, Policy::Deterministic>>(conveyor));
+        }
+        else if (conveyorIndex == statistics->Conveyors.size() - 1)
+        {
+            function(submodel.GetComponent<FinalConveyorScriptBehavior<Mode, Policy::Deterministic>>(conveyor));
+        }
+        else
+        {
+            function(submodel.GetComponent<IntermediateConveyorScriptBehavior<Mode, Policy::Deterministic>>(conveyor));
+        }
+    }
+
+    template <ToteMode Mode, typename Policy>
+    uint64_t BasicConveyorScriptBehavior<Mode, Policy>::ChildCount(
+        Ers::SubModel& submodel, const SubModelStatistics* statistics, uint64_t conveyorIndex)
+    {
+        if constexpr (Mode == ToteMode::Entity)
+        {
+            const EntityID& conveyor = statistics->Conveyors.at(conveyorIndex);
+            return submodel.HasComponent<Ers::RelationComponent>(conveyor)
+                       ? submodel.GetComponent<Ers::RelationComponent>(conveyor)->ChildCount()
+                       : 0;
+        }
+        else
+        {
+            uint64_t childCount = 0;
+            VisitConveyor(submodel, statistics, conveyorIndex, [&](auto* conveyorBehavior) { childCount = conveyorBehavior->ToteQueue.Size(); });
+            return childCount;
+        }
+    }
+
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::MoveToConveyor(
+        Ers::SubModel& submodel, const SubModelStatistics* statistics, uint64_t conveyorIndex, const EntityID& tote)
+    {
+        if constexpr (Mode == ToteMode::Entity)
+        {
+            submodel.UpdateParentOnEntity(tote, statistics->Conveyors.at(conveyorIndex));
+        }
+        else
+        {
+            // Copy first, the reference may point into the ring buffer that OnExited pops
+            const EntityID movedTote = tote;
+
+            // Fire the callbacks the same way UpdateParentOnEntity does for entities
+            OnExited(movedTote);
+            VisitConveyor(submodel, statistics, conveyorIndex, [&](auto* conveyorBehavior) { conveyorBehavior->OnEntered(movedTote); });
+        }
+    }
+
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::MoveOutOfLine(Ers::SubModel& submodel, const EntityID& tote)
+    {
+        if constexpr (Mode == ToteMode::Entity)
+        {
+            submodel.UpdateParentOnEntity(tote, Ers::Entity::InvalidEntity);
+        }
+        else
+        {
+            OnExited(tote);
+        }
+    }
 
-        if (statistics->Conveyors.size() - 1 == properties->ConveyorIndex)
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::NotifyPreviousConveyor(
+        Ers::SubModel& submodel, const SubModelStatistics* statistics, const ConveyorPropertiesComponent* properties)
+    {
+        // Schedule event on the previous conveyor to keep shrink queue
+        const uint64_t previousConveyorIndex = properties->ConveyorIndex - 1;
+
+        // A tote left the first conveyor after the inbox, so the previous chunk may hand over another one
+        if (previousConveyorIndex == 0 && ReceivesFromChunk(statistics))
+        {
+            ReturnCreditEventData creditData;
+            creditData.Generation = statistics->Generation;
+            creditData.Time       = submodel.GetSubModelContext<ToteLogContext>().Now + statistics->ChunkSyncDelay;
+            Ers::EventScheduler::ScheduleSyncEvent<ReturnCreditEventData>(statistics->ChunkSyncDelay, statistics->PreviousChunkSimulatorID, creditData);
+        }
+
+        auto previousConveyorProperties =
+            submodel.GetComponent<ConveyorPropertiesComponent>(statistics->Conveyors.at(previousConveyorIndex));
+        if (!previousConveyorProperties->AllowedToMoveOut)
         {
-            auto simulator                  = submodel.GetSimulator();
-            const int32_t targetSimulatorId = simulator.FindOutgoingDependency("Final simulator").GetID();
+            return;
+        }
 
-            // Prepare for sync
-            submodel.UpdateParentOnEntity(primedTote, Ers::Entity::InvalidEntity);
+        // When the previous conveyor has a ready tote, it sends it to this conveyor immediately
+        VisitConveyor(
+            submodel, statistics, previousConveyorIndex, [](auto* previousConveyorScriptBehaviour) { previousConveyorScriptBehaviour->MoveRequest(); });
+    }
 
-            SimulationTime delay = 1 * submodel.GetModelPrecision();
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::DelayOrMove(const EntityID& primedTote)
+    {
+        auto& submodel = Ers::SubModel::Get();
 
-            // Schedule sync event, please note that the SharedState is cached when multiple events that share this are scheduled.
-            // The Shared State is intended to resolve entities, generate data or other heavy operations that don't have to be repeated.
-            SendToFinalSubModelEventData syncData;
-            syncData.PrimedTote = primedTote;
-            Ers::EventScheduler::ScheduleSyncEvent<SendToFinalSubModelEventData>(delay, targetSimulatorId, syncData);
+        auto properties = submodel.GetComponent<ConveyorPropertiesComponent>(ConnectedEntity);
 
-            if (properties->ConveyorIndex == 0)
+        // Add randomized delay, deterministic conveyors skip the draw altogether
+        if constexpr (!Policy::Deterministic)
+        {
+            if (DelayChanceStream.Sample() * 100.0 <= static_cast<double>(properties->ChanceOfDelay))
             {
+                SimulationTime randomDelay((DelayLengthStream.Sample() * 100000) / 100000);
+
+                randomDelay *= SimulationTime(properties->DelayTimeMax - properties->DelayTimeMin);
+
+                SimulationTime delay(properties->DelayTimeMin);
+                delay += randomDelay;
+                delay *= submodel.GetModelPrecision();
+
+                ScheduleDelayOrMove(submodel.GetSubModelContext<ToteLogContext>(), primedTote, delay);
                 return;
             }
+        }
+
+        ReadyTotes.Push(primedTote);
+        properties->AllowedToMoveOut = true;
+
+        MoveRequest();
+    }
+
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::MoveRequest()
+    {
+        if (ReadyTotes.Empty())
+        {
+            return;
+        }
+
+        auto& submodel = Ers::SubModel::Get();
+
+        auto properties = submodel.GetComponent<ConveyorPropertiesComponent>(ConnectedEntity);
+        auto statistics = submodel.GetComponent<SubModelStatistics>(properties->StatisticsEntity);
 
-            properties->AllowedToMoveOut = false;
+        if (IsLastConveyor(properties, statistics))
+        {
+            const uint32_t targetSimulatorId = statistics->SinkSimulatorID;
 
-            // Schedule event on the previous conveyor to keep shrink queue
-            const EntityID& previousConveyor     = statistics->Conveyors.at(properties->ConveyorIndex - 1);
-            auto previousConveyorProperties      = submodel.GetComponent<ConveyorPropertiesComponent>(previousConveyor);
-            auto previousConveyorScriptBehaviour = submodel.GetComponent<ConveyorScriptBehavior>(previousConveyor);
-            if (!previousConveyorProperties->AllowedToMoveOut)
+            // The next chunk has no room until it returns a credit
+            if (SendsToChunk(statistics) && statistics->Credits == 0)
             {
                 return;
             }
 
-            // When enough totes exist in previous conveyor notify that conveyor
-            // This will trigger the move event early for the other conveyor to send it's tote to this conveyor immediately
-            if (previousConveyorScriptBehaviour->ToteQueue.empty())
+            // Prepare for sync, the tote is no longer on the conveyor once it has left
+            const EntityID syncTote = ReadyTotes.Front();
+            const EntityID lineTote = LineToteOf<Mode>(submodel, syncTote);
+            ReadyTotes.Pop();
+            MoveOutOfLine(submodel, syncTote);
+
+            if (SendsToChunk(statistics))
+            {
+                statistics->Credits--;
+
+                HandOffToteEventData<Mode> handOffData;
+                handOffData.PrimedTote = syncTote;
+                handOffData.Generation = Generation;
+                handOffData.LineTote   = lineTote;
+                handOffData.Time       = submodel.GetSubModelContext<ToteLogContext>().Now + statistics->ChunkSyncDelay;
+                Ers::EventScheduler::ScheduleSyncEvent<HandOffToteEventData<Mode>>(statistics->ChunkSyncDelay, targetSimulatorId, handOffData);
+            }
+            else
+            {
+                SimulationTime delay = SinkSyncDelay * submodel.GetModelPrecision();
+
+                // Schedule sync event, please note that the SharedState is cached when multiple events that share this are scheduled.
+                // The Shared State is intended to resolve entities, generate data or other heavy operations that don't have to be repeated.
+                SendToFinalSubModelEventData<Mode> syncData;
+                syncData.PrimedTote = syncTote;
+                syncData.Generation = Generation;
+                syncData.LineTote   = lineTote;
+                syncData.Time       = submodel.GetSubModelContext<ToteLogContext>().Now + delay;
+                Ers::EventScheduler::ScheduleSyncEvent<SendToFinalSubModelEventData<Mode>>(delay, targetSimulatorId, syncData);
+            }
+
+            // Once the last tote has been sent, the promise changes with the conveyor being empty
+            if (PromisesToSink && ToteQueue.Empty())
+            {
+                UpdateSinkPromise();
+            }
+
+            if (IsFirstConveyor(properties))
             {
                 return;
             }
 
-            const EntityID& previousConveyorTote = previousConveyorScriptBehaviour->ToteQueue.front();
-            submodel.GetComponent<ConveyorScriptBehavior>(previousConveyor)->MoveRequest(previousConveyorTote);
+            properties->AllowedToMoveOut = !ReadyTotes.Empty();
+
+            NotifyPreviousConveyor(submodel, statistics, properties);
             return;
         }
 
-        const EntityID& nextConveyor = statistics->Conveyors.at(properties->ConveyorIndex + 1);
-        auto nextConveyorProperties  = submodel.GetComponent<ConveyorPropertiesComponent>(nextConveyor);
-        int childCount               = submodel.HasComponent<Ers::RelationComponent>(nextConveyor)
-                                           ? submodel.GetComponent<Ers::RelationComponent>(nextConveyor)->ChildCount()
-                                           : 0;
-        if (childCount >= nextConveyorProperties->Capacity)
+        const uint64_t nextConveyorIndex = properties->ConveyorIndex + 1;
+        auto nextConveyorProperties = submodel.GetComponent<ConveyorPropertiesComponent>(statistics->Conveyors.at(nextConveyorIndex));
+        if (ChildCount(submodel, statistics, nextConveyorIndex) >= nextConveyorProperties->Capacity)
         {
             return;
         }
 
-        submodel.UpdateParentOnEntity(primedTote, nextConveyor);
+        const EntityID movedTote = ReadyTotes.Front();
+        ReadyTotes.Pop();
+        MoveToConveyor(submodel, statistics, nextConveyorIndex, movedTote);
         statistics->NumberOfMovedEntities++;
 
-        if (properties->ConveyorIndex == 0)
+        if (IsFirstConveyor(properties))
         {
             return;
         }
 
-        properties->AllowedToMoveOut = false;
+        properties->AllowedToMoveOut = !ReadyTotes.Empty();
 
-        // Schedule event on the previous conveyor to keep shrink queue
-        const EntityID& previousConveyor     = statistics->Conveyors.at(properties->ConveyorIndex - 1);
-        auto previousConveyorProperties      = submodel.GetComponent<ConveyorPropertiesComponent>(previousConveyor);
-        auto previousConveyorScriptBehaviour = submodel.GetComponent<ConveyorScriptBehavior>(previousConveyor);
-        if (!previousConveyorProperties->AllowedToMoveOut)
+        NotifyPreviousConveyor(submodel, statistics, properties);
+    }
+
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::ScheduleDelayOrMove(
+        const ToteLogContext& context, const EntityID& tote, SimulationTime delay)
+    {
+        if (!BundleEvents)
+        {
+            CountScheduledEvent();
+            Ers::EventScheduler::ScheduleLocalEvent(
+                0, delay, TriggerDelayOrMoveEvent<BasicConveyorScriptBehavior>{ConnectedEntity, tote, Generation, context.Now + delay});
+            return;
+        }
+
+        const SimulationTime dueTime = context.Now + delay;
+        DueTotes.push_back(DueTote{dueTime, DueToteSequence++, tote});
+        std::push_heap(DueTotes.begin(), DueTotes.end(), std::greater<DueTote>());
+
+        // Only a tote that is due before the pending wake-up needs an event of its own, the pending one turns stale
+        if (WakeUpTime == NoWakeUp || dueTime < WakeUpTime)
+        {
+            ScheduleWakeUp(context, dueTime);
+        }
+    }
+
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::ScheduleWakeUp(const ToteLogContext& context, SimulationTime time)
+    {
+        WakeUpTime = time;
+        CountScheduledEvent();
+        Ers::EventScheduler::ScheduleLocalEvent(
+            0, time - context.Now, TriggerWakeUpEvent<BasicConveyorScriptBehavior>{ConnectedEntity, Generation, time});
+    }
+
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::CountScheduledEvent()
+    {
+        ScheduledEvents++;
+        PendingEvents++;
+        PeakPendingEvents = std::max(PeakPendingEvents, PendingEvents);
+    }
+
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::WakeUp()
+    {
+        const ToteLogContext& context = Ers::SubModel::Get().GetSubModelContext<ToteLogContext>();
+
+        // Totes added while the due totes are processed are due now or later, so they never need an event of their own
+        WakeUpTime = context.Now;
+        while (!DueTotes.empty() && DueTotes.front().Time <= context.Now)
+        {
+            std::pop_heap(DueTotes.begin(), DueTotes.end(), std::greater<DueTote>());
+            const EntityID tote = DueTotes.back().Tote;
+            DueTotes.pop_back();
+
+            DelayOrMove(tote);
+        }
+
+        WakeUpTime = NoWakeUp;
+        if (!DueTotes.empty())
+        {
+            ScheduleWakeUp(context, DueTotes.front().Time);
+        }
+    }
+
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::UpdateSinkPromise()
+    {
+        auto& submodel  = Ers::SubModel::Get();
+        auto properties = submodel.GetComponent<ConveyorPropertiesComponent>(ConnectedEntity);
+        auto statistics = submodel.GetComponent<SubModelStatistics>(properties->StatisticsEntity);
+
+        // An empty conveyor sends no tote before one has entered and stayed the minimum time, however long it stays empty, which
+        // keeps the promise valid as time advances, see LookaheadPromise. A tote on the conveyor can be sent at any time, when its
+        // delays end or a credit returns, so then only the sync delay is promised.
+        const SimulationTime timeUntilNextSend =
+            ToteQueue.Empty() ? static_cast<SimulationTime>(properties->MinimumTime) * submodel.GetModelPrecision() : 0;
+        SinkPromise.Update(statistics->SinkSimulatorID, timeUntilNextSend);
+    }
+
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::OnCreditReturned(SubModelStatistics* statistics)
+    {
+        statistics->Credits++;
+        MoveRequest();
+    }
+
+    template <ToteMode Mode, typename Policy>
+    void BasicConveyorScriptBehavior<Mode, Policy>::LogTote(
+        Ers::SubModel& submodel, ToteLogContext& context, ToteLog::RecordType type, EntityID tote)
+    {
+        // The conveyor index is only looked up when a log is attached
+        if (context.Producer == nullptr)
+        {
+            return;
+        }
+
+        uint64_t conveyorIndex = 0;
+        if constexpr (!IsSource)
+        {
+            conveyorIndex = submodel.GetComponent<ConveyorPropertiesComponent>(ConnectedEntity)->ConveyorIndex;
+        }
+
+        // The inbox of a chunk is not a conveyor of the line, the first conveyor of every chunk after the first is an inbox
+        if constexpr (IsGeneric)
+        {
+            if (context.FirstConveyor > 0 && conveyorIndex == 0)
+            {
+                return;
+            }
+        }
+        context.Log(type, context.Line, context.FirstConveyor + conveyorIndex, LineToteOf<Mode>(submodel, tote));
+    }
+
+    // Calls function with the behavior of a conveyor, whichever of the behavior types the model builder gave it
+    template <ToteMode Mode, typename Function>
+    void VisitConveyorBehavior(Ers::SubModel& submodel, EntityID conveyor, Function&& function)
+    {
+        if (submodel.HasComponent<BasicConveyorScriptBehavior<Mode>>(conveyor))
+        {
+            function(submodel.GetComponent<BasicConveyorScriptBehavior<Mode>>(conveyor));
+        }
+        else if (submodel.HasComponent<SourceConveyorScriptBehavior<Mode, false>>(conveyor))
+        {
+            function(submodel.GetComponent<SourceConveyorScriptBehavior<Mode, false>>(conveyor));
+        }
+        else if (submodel.HasComponent<SourceConveyorScriptBehavior<Mode, true>>(conveyor))
+        {
+            function(submodel.GetComponent<SourceConveyorScriptBehavior<Mode, true>>(conveyor));
+        }
+        else if (submodel.HasComponent<IntermediateConveyorScriptBehavior<Mode, false>>(conveyor))
+        {
+            function(submodel.GetComponent<IntermediateConveyorScriptBehavior<Mode, false>>(conveyor));
+        }
+        else if (submodel.HasComponent<IntermediateConveyorScriptBehavior<Mode, true>>(conveyor))
+        {
+            function(submodel.GetComponent<IntermediateConveyorScriptBehavior<Mode, true>>(conveyor));
+        }
+        else if (submodel.HasComponent<FinalConveyorScriptBehavior<Mode, false>>(conveyor))
+        {
+            function(submodel.GetComponent<FinalConveyorScriptBehavior<Mode, false>>(conveyor));
+        }
+        else if (submodel.HasComponent<FinalConveyorScriptBehavior<Mode, true>>(conveyor))
+        {
+            function(submodel.GetComponent<FinalConveyorScriptBehavior<Mode, true>>(conveyor));
+        }
+    }
+
+    // Starts tote generation on the first conveyor of a line
+    template <ToteMode Mode>
+    void CreateFirstTote(Ers::SubModel& submodel, EntityID firstConveyor)
+    {
+        VisitConveyorBehavior<Mode>(submodel, firstConveyor, [](auto* conveyorBehavior) { conveyorBehavior->CreateToteEvent(); });
+    }
+
+    template <ToteMode Mode>
+    void HandOffToteEventData<Mode>::OnTargetSide()
+    {
+        AllocationAudit::EventScope auditScope(AllocationAudit::Event::ReceiveTote);
+        auto& targetSubModel = Ers::SubModel::Get();
+        CountEvent(targetSubModel, Time);
+        auto& toteLogContext = targetSubModel.GetSubModelContext<ToteLogContext>();
+        toteLogContext.Advance(Time);
+
+        EntityID tote = PrimedTote;
+        if constexpr (Mode == ToteMode::Entity)
+        {
+            tote = EntityID(targetSubModel.ReceiveEntity(Ers::SyncEvent::GetSyncEventSender(), Ers::SentEntity(PrimedTote)));
+        }
+
+        auto statistics = targetSubModel.GetComponent<SubModelStatistics>(targetSubModel.GetSubModelContext<LineContext>().StatisticsEntity);
+
+        // Sent before the model was reset
+        if (Generation != statistics->Generation)
         {
+            if constexpr (Mode == ToteMode::Entity)
+            {
+                targetSubModel.DestroyEntity(tote);
+            }
             return;
         }
 
-        if (previousConveyorScriptBehaviour->ToteQueue.empty())
+        // The received entity gets a new ID, the log keeps identifying it by its ID in the line. A lightweight tote keeps its ID.
+        if constexpr (Mode == ToteMode::Entity)
+        {
+            if (toteLogContext.Producer != nullptr)
+            {
+                auto* identity = targetSubModel.HasComponent<ToteIdentityComponent>(tote)
+                                     ? targetSubModel.GetComponent<ToteIdentityComponent>(tote)
+                                     : targetSubModel.AddComponent<ToteIdentityComponent>(tote);
+                identity->LineTote = LineTote;
+            }
+        }
+
+        // The inbox passes the tote on like a source does, as soon as the first conveyor has room
+        const EntityID inbox = statistics->Conveyors.at(0);
+        if constexpr (Mode == ToteMode::Entity)
+        {
+            targetSubModel.UpdateParentOnEntity(tote, inbox);
+        }
+        else
+        {
+            VisitConveyorBehavior<Mode>(targetSubModel, inbox, [tote](auto* conveyorBehavior) { conveyorBehavior->OnEntered(tote); });
+        }
+    }
+
+    void ReturnCreditEventData::OnTargetSide()
+    {
+        AllocationAudit::EventScope auditScope(AllocationAudit::Event::ReturnCredit);
+        auto& targetSubModel = Ers::SubModel::Get();
+        CountEvent(targetSubModel, Time);
+        targetSubModel.GetSubModelContext<ToteLogContext>().Advance(Time);
+
+        auto statistics = targetSubModel.GetComponent<SubModelStatistics>(targetSubModel.GetSubModelContext<LineContext>().StatisticsEntity);
+
+        // Sent before the model was reset
+        if (Generation != statistics->Generation)
         {
             return;
         }
 
-        const EntityID& previousConveyorTote = previousConveyorScriptBehaviour->ToteQueue.front();
-        submodel.GetComponent<ConveyorScriptBehavior>(previousConveyor)->MoveRequest(previousConveyorTote);
+        const EntityID lastConveyor = statistics->Conveyors.back();
+        if (statistics->LightweightTotes)
+        {
+            VisitConveyorBehavior<ToteMode::Lightweight>(
+                targetSubModel, lastConveyor, [&](auto* conveyorBehavior) { conveyorBehavior->OnCreditReturned(statistics); });
+        }
+        else
+        {
+            VisitConveyorBehavior<ToteMode::Entity>(
+                targetSubModel, lastConveyor, [&](auto* conveyorBehavior) { conveyorBehavior->OnCreditReturned(statistics); });
+        }
     }
 
     const char* WealthOfRows::SubModelStatistics::StatisticsEntityName = "Statistics";
@@ -461,10 +1489,17 @@ namespace WealthOfRows
         properties->Capacity         = 0;
 
         // Only create the initial tote if we haven't already done so
-        // This prevents duplicate totes when loading a saved model
-        if (!HasStartedInitialization)
+        // This prevents duplicate totes when loading a saved model. The inbox of a chunk gets its totes from the previous chunk.
+        if (!HasStartedInitialization && !ReceivesFromChunk)
         {
-            submodel.GetComponent<ConveyorScriptBehavior>(firstConveyor)->CreateToteEvent();
+            if (LightweightTotes)
+            {
+                CreateFirstTote<ToteMode::Lightweight>(submodel, firstConveyor);
+            }
+            else
+            {
+                CreateFirstTote<ToteMode::Entity>(submodel, firstConveyor);
+            }
             HasStartedInitialization = true;
         }
     }
@@ -480,6 +1515,21 @@ namespace WealthOfRows
 
         // Save/load initialization flag to prevent duplicate tote creation
         node.Serialize("has_started_initialization", HasStartedInitialization);
+
+        // Save/load the tote mode, which determines the conveyor behavior type
+        node.Serialize("lightweight_totes", LightweightTotes);
+
+        node.Serialize("generation", Generation);
+        node.Serialize("sink_simulator_id", SinkSimulatorID);
+
+        // Save/load the chunk of the line
+        node.Serialize("line_index", LineIndex);
+        node.Serialize("first_conveyor_index", FirstConveyorIndex);
+        node.Serialize("receives_from_chunk", ReceivesFromChunk);
+        node.Serialize("sends_to_chunk", SendsToChunk);
+        node.Serialize("previous_chunk_simulator_id", PreviousChunkSimulatorID);
+        node.Serialize("credits", Credits);
+        node.Serialize("chunk_sync_delay", ChunkSyncDelay);
     }
 
     void SinkPropertiesComponent::Serialization(Ers::Serializer node)
@@ -487,169 +1537,1534 @@ namespace WealthOfRows
         // Save/load received totes counter
         node.Serialize("received_totes", ReceivedTotes);
 
-        // Save/load incoming queues - recursive serialization handles nested vector<queue<EntityID>>
-        node.Serialize("incoming_queues", IncomingQueues);
+        // Save/load incoming queues field by field, the count is read first when loading so the queues can be created
+        uint64_t incomingQueueCount = IncomingQueues.size();
+        node.Serialize("incoming_queue_count", incomingQueueCount);
+        IncomingQueues.resize(incomingQueueCount);
+        for (uint64_t i = 0; i < incomingQueueCount; i++)
+        {
+            node.Serialize(std::format("incoming_slots_{}", i).c_str(), IncomingQueues[i].Slots);
+            node.Serialize(std::format("incoming_head_{}", i).c_str(), IncomingQueues[i].Head);
+            node.Serialize(std::format("incoming_count_{}", i).c_str(), IncomingQueues[i].Count);
+        }
+
+        uint64_t incomingLineToteCount = IncomingLineTotes.size();
+        node.Serialize("incoming_line_tote_count", incomingLineToteCount);
+        IncomingLineTotes.resize(incomingLineToteCount);
+        for (uint64_t i = 0; i < incomingLineToteCount; i++)
+        {
+            node.Serialize(std::format("incoming_line_tote_slots_{}", i).c_str(), IncomingLineTotes[i].Slots);
+            node.Serialize(std::format("incoming_line_tote_head_{}", i).c_str(), IncomingLineTotes[i].Head);
+            node.Serialize(std::format("incoming_line_tote_count_{}", i).c_str(), IncomingLineTotes[i].Count);
+        }
+
+        node.Serialize("line_count", LineCount);
+        node.Serialize("receives_line_totes", ReceivesLineTotes);
+        node.Serialize("first_incoming_simulator_id", FirstIncomingSimulatorID);
+        node.Serialize("first_line_index", FirstLineIndex);
+        node.Serialize("forwards", Forwards);
+        node.Serialize("forward_simulator_id", ForwardSimulatorID);
+
+        node.Serialize("generation", Generation);
     }
 
-    void CreateSubModel(Ers::ModelContainer& modelContainer, int conveyorCount, uint64_t chanceOfDelay)
+    // A line of conveyors that is simulated in fixed time steps instead of event by event, see TimeSteppedLine.
+    // On dense lines nearly every step moves a tote on every conveyor, so a single event per step replaces the events of all totes.
+    // The line sends its totes to its sink through the same sync event and promise as an event driven line.
+    class TimeSteppedLineComponent : public Ers::ScriptBehaviorComponent
     {
-        auto newSimulator =
-            modelContainer.AddSimulator(std::to_string(modelContainer.GetSimulators().size()), Ers::SimulatorType::DiscreteEvent);
-
-        newSimulator.EnterSubModel();
-        auto& submodel = Ers::SubModel::Get();
+      public:
+        void OnStart() override;
+        void Serialization(Ers::Serializer node) override;
 
-        auto& sm                        = Ers::SubModel::Get();
-        const EntityID statisticsEntity = submodel.CreateEntity(SubModelStatistics::StatisticsEntityName);
-        auto statisticProperties        = submodel.AddComponent<SubModelStatistics>(statisticsEntity);
+        void Step();
 
-        for (size_t i = 0; i < conveyorCount + 1; i++)
-        {
-            const EntityID conveyorEntity = submodel.CreateEntity(std::format("Conveyor {}", i));
+        TimeSteppedLine Line;
+        SimulationTime StepTime{1};
+        SimulationTime TimeToNextArrival{0};
+        bool HasStartedInitialization{false};
 
-            auto properties              = submodel.AddComponent<ConveyorPropertiesComponent>(conveyorEntity);
-            properties->ConveyorIndex    = statisticProperties->Conveyors.size();
-            properties->ChanceOfDelay    = chanceOfDelay;
-            properties->StatisticsEntity = statisticsEntity;
-            submodel.AddComponent<ConveyorScriptBehavior>(conveyorEntity);
-            statisticProperties->Conveyors.emplace_back(conveyorEntity);
-        }
+        // Set by the model builder, like SubModelStatistics::SinkSimulatorID
+        uint32_t SinkSimulatorID{0};
 
-        newSimulator.ExitSubModel();
-    }
+        // Generation of the model the line runs in, like SubModelStatistics::Generation
+        uint64_t Generation{0};
 
-    void CreateFinalSubModel(Ers::ModelContainer& modelContainer)
-    {
-        auto simulator = modelContainer.AddSimulator("Final simulator", Ers::SimulatorType::DiscreteEvent);
+        // Promise to the final simulator, updated in every step when AutomaticPromise is set
+        bool AutomaticPromise{false};
+        ErsExamples::LookaheadPromise SinkPromise;
 
-        simulator.EnterSubModel();
-        auto& submodel = Ers::SubModel::Get();
+        RandomStream ToteArrivalStream;
+        RandomStream DelayChanceStream;
+        RandomStream DelayLengthStream;
 
-        EntityID sinkEntity = submodel.CreateEntity("Sink");
-        auto sinkProperties = submodel.AddComponent<SinkPropertiesComponent>(sinkEntity);
+        static const char* LineEntityName;
+    };
 
-        sinkProperties->ReceivedTotes = 0;
+    // Event to advance a time-stepped line by one step, the line schedules the next one
+    struct TriggerTimeStepEvent
+    {
+        EntityID entity;
+        uint64_t generation;
+        SimulationTime time;
 
-        // Add dependencies based on all other submodels that need to feed this submodel
-        const size_t simulatorCount = modelContainer.GetSimulators().size() - 1;
-        for (size_t i = 0; i < simulatorCount; i++)
+        void OnEvent()
         {
-            const std::string simulatorName = std::to_string(i);
-            auto dependencySimulator        = modelContainer.FindSimulator(simulatorName);
-            if (dependencySimulator.Valid())
+            AllocationAudit::EventScope auditScope(AllocationAudit::Event::TimeStep);
+            auto& submodel = Ers::SubModel::Get();
+            CountEvent(submodel, time);
+
+            // The chain of steps of a previous run ends here, the reset started a new one
+            auto line = submodel.GetComponent<TimeSteppedLineComponent>(entity);
+            if (line->Generation != generation)
             {
-                modelContainer.AddSimulatorDependency(dependencySimulator, simulator);
-                SimulationTime minimalDelay = 1 * submodel.GetModelPrecision();
-                dependencySimulator.EnterSubModel();
-                Ers::EventScheduler::SetPromise(simulator.GetID(), minimalDelay);
-                dependencySimulator.ExitSubModel();
+                return;
             }
-            sinkProperties->IncomingQueues.emplace_back(); // Add a new queue for each incoming conveyor line
+
+            submodel.GetSubModelContext<ToteLogContext>().Advance(time);
+            line->Step();
         }
 
-        simulator.ExitSubModel();
-    }
+        ERS_EVENT(entity, generation, time)
+    };
+
+    const char* TimeSteppedLineComponent::LineEntityName = "Time-stepped line";
+
+    void TimeSteppedLineComponent::OnStart()
+    {
+        // Prevents a second chain of steps when loading a saved model
+        if (!HasStartedInitialization)
+        {
+            Ers::EventScheduler::ScheduleLocalEvent(
+                0, SimulationTime(0), TriggerTimeStepEvent{ConnectedEntity, Generation, SimulationTime(0)});
+            HasStartedInitialization = true;
+        }
+    }
+
+    void TimeSteppedLineComponent::Step()
+    {
+        auto& submodel       = Ers::SubModel::Get();
+        auto& toteLogContext = submodel.GetSubModelContext<ToteLogContext>();
+
+        // Totes arrive with the same distribution as at the source of an event driven line, they wait at the source until the
+        // first segment is empty
+        TimeToNextArrival -= StepTime;
+        while (TimeToNextArrival <= 0)
+        {
+            toteLogContext.Log(ToteLog::RecordType::Created, toteLogContext.Line, 0, Line.GeneratedTotes);
+            Line.PendingTotes++;
+            Line.GeneratedTotes++;
+
+            SimulationTime arrivalDelay =
+                std::round(ToteArrivalStream.Sample() * static_cast<double>(1'000'000)) * submodel.GetModelPrecision();
+            TimeToNextArrival += arrivalDelay / SimulationTime(100000);
+        }
+
+        uint64_t exitedTote = 0;
+        if (Line.Step(DelayChanceStream, DelayLengthStream, exitedTote))
+        {
+            const SimulationTime delay = SinkSyncDelay * submodel.GetModelPrecision();
+
+            SendToFinalSubModelEventData<ToteMode::Lightweight> syncData;
+            syncData.PrimedTote = exitedTote;
+            syncData.Generation = Generation;
+            syncData.LineTote   = exitedTote;
+            syncData.Time       = toteLogContext.Now + delay;
+            Ers::EventScheduler::ScheduleSyncEvent<SendToFinalSubModelEventData<ToteMode::Lightweight>>(delay, SinkSimulatorID, syncData);
+        }
+
+        // A tote on the last segment leaves once its remaining steps ran out, a tote that enters it later stays the minimum steps.
+        // The sender side of the sync events advances the time of the line between the steps, so the promise counts from the next
+        // step, which replaces it, see LookaheadPromise.
+        if (AutomaticPromise)
+        {
+            const int32_t stepsUntilNextSend =
+                Line.Occupied.back() ? std::max(Line.RemainingSteps.back(), 1) : Line.MinimumSteps + 1;
+            SinkPromise.Update(SinkSimulatorID, (stepsUntilNextSend - 1) * StepTime);
+        }
+
+        Ers::EventScheduler::ScheduleLocalEvent(
+            0, StepTime, TriggerTimeStepEvent{ConnectedEntity, Generation, toteLogContext.Now + StepTime});
+    }
+
+    void TimeSteppedLineComponent::Serialization(Ers::Serializer node)
+    {
+        // Save/load the segment arrays, the next state arrays are overwritten by every step
+        node.Serialize("occupied", Line.Occupied);
+        node.Serialize("remaining_steps", Line.RemainingSteps);
+        node.Serialize("totes", Line.Totes);
+        node.Serialize("minimum_steps", Line.MinimumSteps);
+        node.Serialize("chance_of_delay", Line.ChanceOfDelay);
+        node.Serialize("delay_steps_min", Line.DelayStepsMin);
+        node.Serialize("delay_steps_max", Line.DelayStepsMax);
+        node.Serialize("pending_totes", Line.PendingTotes);
+        node.Serialize("generated_totes", Line.GeneratedTotes);
+        node.Serialize("moved_totes", Line.MovedTotes);
+        Line.NextOccupied.resize(Line.Occupied.size());
+        Line.NextRemainingSteps.resize(Line.RemainingSteps.size());
+        Line.NextTotes.resize(Line.Totes.size());
+        Line.Moves.resize(Line.Occupied.size());
+
+        node.Serialize("step_time", StepTime);
+        node.Serialize("time_to_next_arrival", TimeToNextArrival);
+        node.Serialize("has_started_initialization", HasStartedInitialization);
+        node.Serialize("automatic_promise", AutomaticPromise);
+        node.Serialize("sink_simulator_id", SinkSimulatorID);
+        node.Serialize("generation", Generation);
+
+        node.Serialize("tote_arrival_stream", ToteArrivalStream.State);
+        node.Serialize("delay_chance_stream", DelayChanceStream.State);
+        node.Serialize("delay_length_stream", DelayLengthStream.State);
+    }
+
+    // Parameters of a single benchmark run
+    struct ModelSettings
+    {
+        int SubmodelCount{50};
+        int ConveyorCount{10};
+        SimulationTime EndTime{86400};
+        uint64_t ChanceOfDelay{3};
+        ToteMode Mode{ToteMode::Entity};
+        uint64_t Seed{1};
+
+        // Use the source, intermediate and final conveyor behaviors instead of the generic behavior
+        bool SpecializedConveyors{false};
+
+        // Writes a per-tote lifecycle log of the run to this file, when set
+        std::string ToteLogPath;
+
+        // Let every conveyor keep its due totes itself, with a single wake-up event, instead of scheduling an event for every tote
+        bool BundleConveyorEvents{true};
+        uint64_t ConveyorCapacity{1};
+        uint64_t ConveyorMinimumTime{2};
+
+        // Simulate every line in fixed time steps of StepSeconds instead of event by event, totes are always lightweight then
+        bool TimeSteppedLines{false};
+        double StepSeconds{0.5};
+
+        // Let the end of every line keep its promise to the final simulator up to date, instead of promising the sync delay only
+        bool AutomaticPromises{true};
+
+        // Join the lines in a tree of aggregator simulators with this many inputs each in front of the final simulator,
+        // below two the lines send to the final simulator directly
+        uint64_t AggregatorArity{0};
+
+        // Split every event driven line into this many chunks of consecutive conveyors, each in its own simulator. The chunks hand
+        // their totes to each other with sync events of ChunkSyncSeconds.
+        uint64_t LineChunks{1};
+        double ChunkSyncSeconds{0.001};
+    };
+
+    // Number of chunks of every line, a chunk has at least one conveyor besides its source or inbox
+    uint64_t LineChunkCount(const ModelSettings& settings)
+    {
+        if (settings.TimeSteppedLines || settings.ConveyorCount <= 1)
+        {
+            return 1;
+        }
+        return std::clamp<uint64_t>(settings.LineChunks, 1, static_cast<uint64_t>(settings.ConveyorCount));
+    }
+
+    std::string ChunkSimulatorName(uint64_t lineIndex, uint64_t chunk)
+    {
+        return chunk == 0 ? std::to_string(lineIndex) : std::format("{}.{}", lineIndex, chunk);
+    }
+
+    // The simulators of the lines come first in the model, chunk by chunk, followed by the aggregators and the final simulator
+    size_t LineSimulatorCount(const ModelSettings& settings)
+    {
+        return static_cast<size_t>(settings.SubmodelCount) * static_cast<size_t>(LineChunkCount(settings));
+    }
+
+    // Adds the conveyor behavior for the conveyor at conveyorIndex, in a line of settings.ConveyorCount + 1 conveyors.
+    // The last conveyor of a chunk sends its totes to the next chunk or the sink with sync events of syncDelay.
+    template <ToteMode Mode>
+    void AddConveyorBehavior(
+        Ers::SubModel& submodel, EntityID conveyorEntity, uint64_t lineIndex, size_t conveyorIndex, bool lastOfChunk,
+        SimulationTime syncDelay, const ModelSettings& settings)
+    {
+        const bool deterministic = settings.ChanceOfDelay == 0;
+
+        // A line with a single conveyor is both the source and the final conveyor, only the generic behavior handles that.
+        // The generic behavior also handles the inbox and the hand-off of a chunk.
+        if (!settings.SpecializedConveyors || settings.ConveyorCount == 0 || LineChunkCount(settings) > 1)
+        {
+            submodel.AddComponent<BasicConveyorScriptBehavior<Mode>>(conveyorEntity);
+        }
+        else if (conveyorIndex == 0)
+        {
+            if (deterministic)
+            {
+                submodel.AddComponent<SourceConveyorScriptBehavior<Mode, true>>(conveyorEntity);
+            }
+            else
+            {
+                submodel.AddComponent<SourceConveyorScriptBehavior<Mode, false>>(conveyorEntity);
+            }
+        }
+        else if (conveyorIndex == static_cast<size_t>(settings.ConveyorCount))
+        {
+            if (deterministic)
+            {
+                submodel.AddComponent<FinalConveyorScriptBehavior<Mode, true>>(conveyorEntity);
+            }
+            else
+            {
+                submodel.AddComponent<FinalConveyorScriptBehavior<Mode, false>>(conveyorEntity);
+            }
+        }
+        else
+        {
+            if (deterministic)
+            {
+                submodel.AddComponent<IntermediateConveyorScriptBehavior<Mode, true>>(conveyorEntity);
+            }
+            else
+            {
+                submodel.AddComponent<IntermediateConveyorScriptBehavior<Mode, false>>(conveyorEntity);
+            }
+        }
+
+        VisitConveyorBehavior<Mode>(
+            submodel, conveyorEntity,
+            [&](auto* conveyorBehavior)
+            {
+                conveyorBehavior->BundleEvents = settings.BundleConveyorEvents;
+                conveyorBehavior->SeedRandomStreams(settings.Seed, lineIndex, conveyorIndex);
+
+                conveyorBehavior->PromisesToSink = settings.AutomaticPromises && settings.ConveyorCount > 0 && lastOfChunk;
+                conveyorBehavior->SinkPromise = ErsExamples::LookaheadPromise(syncDelay);
+            });
+    }
+
+    // Creates the simulator of a chunk of a line, see LineChunkCount. A line that is not split is a single chunk.
+    void CreateSubModel(Ers::ModelContainer& modelContainer, const ModelSettings& settings, uint64_t lineIndex, uint64_t chunk)
+    {
+        auto newSimulator = modelContainer.AddSimulator(ChunkSimulatorName(lineIndex, chunk), Ers::SimulatorType::DiscreteEvent);
+
+        newSimulator.EnterSubModel();
+        auto& submodel = Ers::SubModel::Get();
+
+        // The chunk holds conveyors firstConveyor to lastConveyor of the line, behind the source or the inbox
+        const uint64_t conveyorCount = static_cast<uint64_t>(settings.ConveyorCount);
+        const uint64_t chunkCount    = LineChunkCount(settings);
+        const uint64_t firstConveyor = 1 + chunk * conveyorCount / chunkCount;
+        const uint64_t lastConveyor  = (chunk + 1) * conveyorCount / chunkCount;
+
+        const SimulationTime chunkSyncDelay =
+            std::max<SimulationTime>(std::llround(settings.ChunkSyncSeconds * static_cast<double>(submodel.GetModelPrecision())), 1);
+
+        const EntityID statisticsEntity         = submodel.CreateEntity(SubModelStatistics::StatisticsEntityName);
+        auto statisticProperties                = submodel.AddComponent<SubModelStatistics>(statisticsEntity);
+        statisticProperties->LightweightTotes   = settings.Mode == ToteMode::Lightweight;
+        statisticProperties->LineIndex          = lineIndex;
+        statisticProperties->FirstConveyorIndex = firstConveyor - 1;
+        statisticProperties->ReceivesFromChunk  = chunk > 0;
+        statisticProperties->SendsToChunk       = chunk + 1 < chunkCount;
+        statisticProperties->Credits            = settings.ConveyorCapacity;
+        statisticProperties->ChunkSyncDelay     = chunkSyncDelay;
+
+        const SimulationTime syncDelay =
+            statisticProperties->SendsToChunk ? statisticProperties->ChunkSyncDelay : SinkSyncDelay * submodel.GetModelPrecision();
+
+        for (uint64_t conveyorIndex = firstConveyor - 1; conveyorIndex <= lastConveyor; conveyorIndex++)
+        {
+            const size_t i                = static_cast<size_t>(conveyorIndex);
+            const bool isInbox            = chunk > 0 && conveyorIndex == firstConveyor - 1;
+            const EntityID conveyorEntity = submodel.CreateEntity(isInbox ? std::string("Inbox") : std::format("Conveyor {}", i));
+
+            auto properties              = submodel.AddComponent<ConveyorPropertiesComponent>(conveyorEntity);
+            properties->ConveyorIndex    = statisticProperties->Conveyors.size();
+            properties->ChanceOfDelay    = settings.ChanceOfDelay;
+            properties->Capacity         = settings.ConveyorCapacity;
+            properties->MinimumTime      = settings.ConveyorMinimumTime;
+            properties->StatisticsEntity = statisticsEntity;
+            if (settings.Mode == ToteMode::Lightweight)
+            {
+                AddConveyorBehavior<ToteMode::Lightweight>(submodel, conveyorEntity, lineIndex, i, i == lastConveyor, syncDelay, settings);
+            }
+            else
+            {
+                AddConveyorBehavior<ToteMode::Entity>(submodel, conveyorEntity, lineIndex, i, i == lastConveyor, syncDelay, settings);
+            }
+            statisticProperties->Conveyors.emplace_back(conveyorEntity);
+        }
+
+        newSimulator.ExitSubModel();
+    }
+
+    void CreateTimeSteppedSubModel(Ers::ModelContainer& modelContainer, const ModelSettings& settings)
+    {
+        const uint64_t lineIndex = modelContainer.GetSimulators().size();
+        auto newSimulator        = modelContainer.AddSimulator(std::to_string(lineIndex), Ers::SimulatorType::DiscreteEvent);
+
+        newSimulator.EnterSubModel();
+        auto& submodel = Ers::SubModel::Get();
+
+        const EntityID lineEntity = submodel.CreateEntity(TimeSteppedLineComponent::LineEntityName);
+        auto line                 = submodel.AddComponent<TimeSteppedLineComponent>(lineEntity);
+
+        const SimulationTime stepTime = std::llround(settings.StepSeconds * static_cast<double>(submodel.GetModelPrecision()));
+        line->StepTime                = std::max<SimulationTime>(stepTime, 1);
+
+        // Every segment behaves like an event driven conveyor with a capacity of one, its times rounded up to whole steps
+        const ConveyorPropertiesComponent conveyor;
+        auto steps = [&](uint64_t seconds)
+        {
+            const SimulationTime time = static_cast<SimulationTime>(seconds) * submodel.GetModelPrecision();
+            return static_cast<int32_t>(std::max<SimulationTime>((time + line->StepTime - 1) / line->StepTime, 1));
+        };
+
+        line->Line.Resize(settings.ConveyorCount);
+        line->Line.MinimumSteps  = steps(settings.ConveyorMinimumTime);
+        line->Line.ChanceOfDelay = settings.ChanceOfDelay;
+        line->Line.DelayStepsMin = steps(conveyor.DelayTimeMin);
+        line->Line.DelayStepsMax = steps(conveyor.DelayTimeMax);
+
+        line->AutomaticPromise = settings.AutomaticPromises;
+        line->SinkPromise      = ErsExamples::LookaheadPromise(SinkSyncDelay * submodel.GetModelPrecision());
+
+        line->ToteArrivalStream = RandomStream::Create(settings.Seed, lineIndex, 0, RandomPurpose::ToteArrival);
+        line->DelayChanceStream = RandomStream::Create(settings.Seed, lineIndex, 0, RandomPurpose::DelayChance);
+        line->DelayLengthStream = RandomStream::Create(settings.Seed, lineIndex, 0, RandomPurpose::DelayLength);
+
+        newSimulator.ExitSubModel();
+    }
+
+    // Counters of the line in the submodel, whether it is event driven or time-stepped
+    void GetLineCounters(Ers::SubModel& submodel, uint64_t& generatedTotes, uint64_t& movedTotes)
+    {
+        const EntityID lineEntity = submodel.FindEntity(TimeSteppedLineComponent::LineEntityName);
+        if (lineEntity != Ers::Entity::InvalidEntity)
+        {
+            const auto line = submodel.GetComponent<TimeSteppedLineComponent>(lineEntity);
+            generatedTotes  = line->Line.GeneratedTotes;
+            movedTotes      = line->Line.MovedTotes;
+            return;
+        }
+
+        const auto statistics = submodel.GetComponent<SubModelStatistics>(submodel.FindEntity(SubModelStatistics::StatisticsEntityName));
+        generatedTotes        = statistics->NumberOfGeneratedEntities;
+        movedTotes            = statistics->NumberOfMovedEntities;
+    }
+
+    // Adds the promises the line in the submodel made to the final simulator to total, whether it is event driven or time-stepped
+    template <ToteMode Mode>
+    void AddSinkPromiseCounters(Ers::SubModel& submodel, ErsExamples::LookaheadPromise& total)
+    {
+        const EntityID lineEntity = submodel.FindEntity(TimeSteppedLineComponent::LineEntityName);
+        if (lineEntity != Ers::Entity::InvalidEntity)
+        {
+            total.Add(submodel.GetComponent<TimeSteppedLineComponent>(lineEntity)->SinkPromise);
+            return;
+        }
+
+        const auto statistics = submodel.GetComponent<SubModelStatistics>(submodel.FindEntity(SubModelStatistics::StatisticsEntityName));
+        VisitConveyorBehavior<Mode>(submodel, statistics->Conveyors.back(), [&](auto* conveyorBehavior) { total.Add(conveyorBehavior->SinkPromise); });
+    }
+
+    // Adds the event counters of the conveyors in the submodel, the peak is the highest number of pending events of a single conveyor
+    template <ToteMode Mode>
+    void AddConveyorEventCounters(Ers::SubModel& submodel, uint64_t& scheduledEvents, uint64_t& peakPendingEvents)
+    {
+        const auto statistics = submodel.GetComponent<SubModelStatistics>(submodel.FindEntity(SubModelStatistics::StatisticsEntityName));
+        for (const EntityID& conveyor : statistics->Conveyors)
+        {
+            VisitConveyorBehavior<Mode>(
+                submodel, conveyor,
+                [&](auto* conveyorBehavior)
+                {
+                    scheduledEvents += conveyorBehavior->ScheduledEvents;
+                    peakPendingEvents = std::max(peakPendingEvents, conveyorBehavior->PeakPendingEvents);
+                });
+        }
+    }
+
+    // Lets the line in the submodel send its totes to the simulator with sinkSimulatorId, whether it is event driven or time-stepped
+    void SetLineSink(Ers::SubModel& submodel, uint32_t sinkSimulatorId)
+    {
+        const EntityID lineEntity = submodel.FindEntity(TimeSteppedLineComponent::LineEntityName);
+        if (lineEntity != Ers::Entity::InvalidEntity)
+        {
+            submodel.GetComponent<TimeSteppedLineComponent>(lineEntity)->SinkSimulatorID = sinkSimulatorId;
+            return;
+        }
+
+        submodel.GetComponent<SubModelStatistics>(submodel.FindEntity(SubModelStatistics::StatisticsEntityName))->SinkSimulatorID =
+            sinkSimulatorId;
+    }
+
+    // Lets chunk of a line hand its totes over from the previous chunk. The previous chunk sends the totes of its last conveyor, and
+    // this chunk returns a credit whenever a tote leaves its first conveyor after the inbox, so both depend on each other.
+    void ConnectChunks(Ers::ModelContainer& modelContainer, const ModelSettings& settings, uint64_t lineIndex, uint64_t chunk)
+    {
+        auto previous = modelContainer.FindSimulator(ChunkSimulatorName(lineIndex, chunk - 1));
+        auto next     = modelContainer.FindSimulator(ChunkSimulatorName(lineIndex, chunk));
+        modelContainer.AddSimulatorDependency(previous, next);
+        modelContainer.AddSimulatorDependency(next, previous);
+
+        // The last conveyor of the previous chunk starts empty, see UpdateSinkPromise
+        SimulationTime timeUntilNextSend(0);
+        if (settings.AutomaticPromises)
+        {
+            timeUntilNextSend = static_cast<SimulationTime>(settings.ConveyorMinimumTime) * modelContainer.GetPrecision();
+        }
+
+        previous.EnterSubModel();
+        auto& previousSubmodel = Ers::SubModel::Get();
+        auto previousStatistics =
+            previousSubmodel.GetComponent<SubModelStatistics>(previousSubmodel.FindEntity(SubModelStatistics::StatisticsEntityName));
+        previousStatistics->SinkSimulatorID = next.GetID();
+        const SimulationTime syncDelay      = previousStatistics->ChunkSyncDelay;
+        ErsExamples::LookaheadPromise(syncDelay).Update(next.GetID(), timeUntilNextSend);
+        previous.ExitSubModel();
+
+        // A credit can be returned as soon as a tote has left the first conveyor, the credits keep the promise of the sync delay
+        next.EnterSubModel();
+        auto& nextSubmodel = Ers::SubModel::Get();
+        nextSubmodel.GetComponent<SubModelStatistics>(nextSubmodel.FindEntity(SubModelStatistics::StatisticsEntityName))
+            ->PreviousChunkSimulatorID = previous.GetID();
+        ErsExamples::LookaheadPromise(syncDelay).Update(previous.GetID(), 0);
+        next.ExitSubModel();
+    }
+
+    // Creates the sink of simulator and makes it depend on inputs, which are either all lines or all aggregators.
+    // Every input promises the sync delay plus timeUntilNextSend, which must hold until the input replaces the promise, see
+    // LookaheadPromise. When the inputs are lines, firstLineIndex is the index of the first of them.
+    void CreateSink(
+        Ers::ModelContainer& modelContainer, Ers::Simulator simulator, const std::vector<Ers::Simulator>& inputs, bool inputsAreLines,
+        uint64_t lineCount, uint64_t firstLineIndex, SimulationTime timeUntilNextSend)
+    {
+        simulator.EnterSubModel();
+        auto& submodel = Ers::SubModel::Get();
+
+        EntityID sinkEntity = submodel.CreateEntity("Sink");
+        auto sinkProperties = submodel.AddComponent<SinkPropertiesComponent>(sinkEntity);
+
+        sinkProperties->ReceivedTotes     = 0;
+        sinkProperties->LineCount         = lineCount;
+        sinkProperties->ReceivesLineTotes = inputsAreLines;
+        sinkProperties->FirstLineIndex    = inputsAreLines ? static_cast<uint32_t>(firstLineIndex) : 0;
+        sinkProperties->IncomingQueues.resize(inputs.size()); // A queue for each incoming conveyor line or aggregator
+        sinkProperties->IncomingLineTotes.resize(inputsAreLines ? inputs.size() : 0);
+        if (!inputs.empty())
+        {
+            auto firstInput                          = inputs.front();
+            sinkProperties->FirstIncomingSimulatorID = firstInput.GetID();
+        }
+
+        const SimulationTime syncDelay = SinkSyncDelay * submodel.GetModelPrecision();
+        simulator.ExitSubModel();
+
+        // Add dependencies based on all other submodels that need to feed this submodel
+        for (auto input : inputs)
+        {
+            modelContainer.AddSimulatorDependency(input, simulator);
+
+            input.EnterSubModel();
+            auto& inputSubmodel = Ers::SubModel::Get();
+            if (inputsAreLines)
+            {
+                SetLineSink(inputSubmodel, simulator.GetID());
+            }
+            else
+            {
+                auto inputSinkProperties                = inputSubmodel.GetComponent<SinkPropertiesComponent>(inputSubmodel.FindEntity("Sink"));
+                inputSinkProperties->Forwards           = true;
+                inputSinkProperties->ForwardSimulatorID = simulator.GetID();
+            }
+            ErsExamples::LookaheadPromise(syncDelay).Update(simulator.GetID(), timeUntilNextSend);
+            input.ExitSubModel();
+        }
+    }
+
+    std::string AggregatorName(uint64_t level, uint64_t index)
+    {
+        return std::format("Aggregator {}.{}", level, index);
+    }
+
+    // Creates the final simulator with the sink that joins the lines. With an aggregator arity of two or more, the lines are joined
+    // in a tree of aggregator simulators in front of it first: every aggregator joins up to arity inputs, and levels are added until
+    // the final simulator has at most arity inputs left. The joins of different aggregators run in parallel, and the final simulator
+    // handles one group per input instead of one tote per line.
+    void CreateFinalSubModel(Ers::ModelContainer& modelContainer, const ModelSettings& settings)
+    {
+        const SimulationTime precision = modelContainer.GetPrecision();
+
+        std::vector<Ers::Simulator> inputs;
+        std::vector<uint64_t> inputLineCounts;
+        // The last chunk of every line sends to the sink
+        const uint64_t lastChunk = LineChunkCount(settings) - 1;
+        for (int i = 0; i < settings.SubmodelCount; i++)
+        {
+            auto lineSimulator = modelContainer.FindSimulator(ChunkSimulatorName(i, lastChunk));
+            if (lineSimulator.Valid())
+            {
+                inputs.push_back(lineSimulator);
+                inputLineCounts.push_back(1);
+            }
+        }
+
+        // The last conveyor of a line, or the last segment of a time-stepped line, starts empty, so a line sends no tote before one
+        // has stayed the minimum time on it, see UpdateSinkPromise. An aggregator forwards a group as soon as it has joined it, so it
+        // only promises the sync delay.
+        SimulationTime lineTimeUntilNextSend(0);
+        if (settings.AutomaticPromises && settings.ConveyorCount > 0)
+        {
+            lineTimeUntilNextSend = static_cast<SimulationTime>(settings.ConveyorMinimumTime) * precision;
+        }
+
+        bool inputsAreLines = true;
+        const uint64_t arity = settings.AggregatorArity;
+        for (uint64_t level = 0; arity >= 2 && inputs.size() > arity; level++)
+        {
+            std::vector<Ers::Simulator> aggregators;
+            std::vector<uint64_t> aggregatorLineCounts;
+            for (size_t first = 0; first < inputs.size(); first += arity)
+            {
+                const size_t last = std::min<size_t>(first + arity, inputs.size());
+                const std::vector<Ers::Simulator> children(inputs.begin() + first, inputs.begin() + last);
+                const uint64_t lineCount = std::accumulate(inputLineCounts.begin() + first, inputLineCounts.begin() + last, uint64_t(0));
+
+                auto aggregator = modelContainer.AddSimulator(AggregatorName(level, first / arity), Ers::SimulatorType::DiscreteEvent);
+                CreateSink(
+                    modelContainer, aggregator, children, inputsAreLines, lineCount, first, inputsAreLines ? lineTimeUntilNextSend : 0);
+                aggregators.push_back(aggregator);
+                aggregatorLineCounts.push_back(lineCount);
+            }
+
+            inputs          = std::move(aggregators);
+            inputLineCounts = std::move(aggregatorLineCounts);
+            inputsAreLines  = false;
+        }
+
+        // Added last, the final simulator is the last simulator of the model
+        auto simulator = modelContainer.AddSimulator("Final simulator", Ers::SimulatorType::DiscreteEvent);
+        CreateSink(
+            modelContainer, simulator, inputs, inputsAreLines, std::accumulate(inputLineCounts.begin(), inputLineCounts.end(), uint64_t(0)), 0,
+            inputsAreLines ? lineTimeUntilNextSend : 0);
+    }
+
+    // Returns whether a model built with builtSettings can be reset to run scenario, instead of being rebuilt
+    bool CanResetModel(const ModelSettings& builtSettings, const ModelSettings& scenario)
+    {
+        // The simulators, conveyors and behavior types are the topology of the model, a deterministic conveyor can't get delays.
+        // The step of a time-stepped line sets the steps of its segments.
+        return builtSettings.TimeSteppedLines == scenario.TimeSteppedLines &&
+               (!scenario.TimeSteppedLines || builtSettings.StepSeconds == scenario.StepSeconds) &&
+               builtSettings.SubmodelCount == scenario.SubmodelCount && builtSettings.ConveyorCount == scenario.ConveyorCount &&
+               builtSettings.Mode == scenario.Mode && builtSettings.SpecializedConveyors == scenario.SpecializedConveyors &&
+               builtSettings.BundleConveyorEvents == scenario.BundleConveyorEvents &&
+               builtSettings.ConveyorCapacity == scenario.ConveyorCapacity && builtSettings.ConveyorMinimumTime == scenario.ConveyorMinimumTime &&
+               builtSettings.AutomaticPromises == scenario.AutomaticPromises && builtSettings.AggregatorArity == scenario.AggregatorArity &&
+               LineChunkCount(builtSettings) == LineChunkCount(scenario) && builtSettings.ChunkSyncSeconds == scenario.ChunkSyncSeconds &&
+               (!scenario.SpecializedConveyors || (builtSettings.ChanceOfDelay == 0) == (scenario.ChanceOfDelay == 0));
+    }
+
+    template <ToteMode Mode>
+    void ResetConveyorSubModel(Ers::SubModel& submodel, const ModelSettings& scenario)
+    {
+        const EntityID statisticsEntity = submodel.FindEntity(SubModelStatistics::StatisticsEntityName);
+        auto statistics                 = submodel.GetComponent<SubModelStatistics>(statisticsEntity);
+
+        statistics->NumberOfGeneratedEntities = 0;
+        statistics->NumberOfMovedEntities     = 0;
+        statistics->Credits                   = scenario.ConveyorCapacity;
+        statistics->Generation++;
+
+        // The totes removed by the reset are not part of the next run, so they are not logged, and the next run starts at time zero
+        auto& toteLogContext                = submodel.GetSubModelContext<ToteLogContext>();
+        ToteLog::Producer* toteLogProducer = std::exchange(toteLogContext.Producer, nullptr);
+        toteLogContext.Now                 = 0;
+
+        for (const EntityID& conveyor : statistics->Conveyors)
+        {
+            auto properties = submodel.GetComponent<ConveyorPropertiesComponent>(conveyor);
+            VisitConveyorBehavior<Mode>(
+                submodel, conveyor,
+                [&](auto* conveyorBehavior)
+                {
+                    conveyorBehavior->Reset(statistics->Generation);
+                    conveyorBehavior->SeedRandomStreams(
+                        scenario.Seed, statistics->LineIndex, statistics->FirstConveyorIndex + properties->ConveyorIndex);
+                });
+
+            // Restore the state that the builder and SubModelStatistics::OnStart give the conveyors
+            properties->AllowedToMoveOut = properties->ConveyorIndex == 0;
+            if (properties->ConveyorIndex != 0)
+            {
+                properties->ChanceOfDelay = scenario.ChanceOfDelay;
+            }
+        }
+
+        toteLogContext.Producer = toteLogProducer;
+        if (!statistics->ReceivesFromChunk)
+        {
+            CreateFirstTote<Mode>(submodel, statistics->Conveyors.at(0));
+        }
+    }
+
+    void ResetTimeSteppedSubModel(Ers::SubModel& submodel, const ModelSettings& scenario, uint64_t lineIndex)
+    {
+        const EntityID lineEntity = submodel.FindEntity(TimeSteppedLineComponent::LineEntityName);
+        auto line                 = submodel.GetComponent<TimeSteppedLineComponent>(lineEntity);
+
+        // Empties the segments, the step and the steps of the segments stay as built
+        line->Line.Resize(scenario.ConveyorCount);
+        line->Line.ChanceOfDelay  = scenario.ChanceOfDelay;
+        line->Line.PendingTotes   = 0;
+        line->Line.GeneratedTotes = 0;
+        line->Line.MovedTotes     = 0;
+        line->TimeToNextArrival   = 0;
+        line->SinkPromise         = ErsExamples::LookaheadPromise(line->SinkPromise.MinimumSyncDelay);
+        line->Generation++;
+
+        line->ToteArrivalStream = RandomStream::Create(scenario.Seed, lineIndex, 0, RandomPurpose::ToteArrival);
+        line->DelayChanceStream = RandomStream::Create(scenario.Seed, lineIndex, 0, RandomPurpose::DelayChance);
+        line->DelayLengthStream = RandomStream::Create(scenario.Seed, lineIndex, 0, RandomPurpose::DelayLength);
+
+        // The next run starts at time zero with a new chain of steps
+        submodel.GetSubModelContext<ToteLogContext>().Now = 0;
+        Ers::EventScheduler::ScheduleLocalEvent(
+            0, SimulationTime(0), TriggerTimeStepEvent{lineEntity, line->Generation, SimulationTime(0)});
+    }
+
+    template <ToteMode Mode>
+    void ResetSink(Ers::SubModel& submodel)
+    {
+        auto sinkProperties = submodel.GetComponent<SinkPropertiesComponent>(submodel.FindEntity("Sink"));
+
+        sinkProperties->ReceivedTotes = 0;
+        for (auto& receivedTotesCollection : sinkProperties->IncomingQueues)
+        {
+            while (!receivedTotesCollection.Empty())
+            {
+                // The queues of an aggregator further down the tree hold joined groups, which are not entities
+                if (Mode == ToteMode::Entity && sinkProperties->ReceivesLineTotes)
+                {
+                    submodel.DestroyEntity(receivedTotesCollection.Front());
+                }
+                receivedTotesCollection.Pop();
+            }
+        }
+        for (auto& lineTotes : sinkProperties->IncomingLineTotes)
+        {
+            lineTotes.Clear();
+        }
+        sinkProperties->Generation++;
+
+        submodel.GetSubModelContext<ToteLogContext>().Now = 0;
+    }
+
+    // Restores the initial component state of a model built with builtSettings for the next scenario, and reseeds its random streams.
+    // The simulators, entities and buffers are kept. Events that are still pending from the previous run are ignored,
+    // since they carry the generation they were scheduled in. Returns false when the scenario needs a rebuild instead.
+    bool ResetModel(Ers::ModelContainer& modelContainer, const ModelSettings& builtSettings, const ModelSettings& scenario)
+    {
+        if (!CanResetModel(builtSettings, scenario))
+        {
+            return false;
+        }
+
+        modelContainer.SetSeed(scenario.Seed);
+
+        const std::vector<Ers::Simulator> simulators = modelContainer.GetSimulators();
+        const size_t lineSimulatorCount              = LineSimulatorCount(scenario);
+        for (size_t i = 0; i < lineSimulatorCount; i++)
+        {
+            auto simulator = simulators[i];
+            simulator.EnterSubModel();
+            if (scenario.TimeSteppedLines)
+            {
+                ResetTimeSteppedSubModel(Ers::SubModel::Get(), scenario, i);
+            }
+            else if (scenario.Mode == ToteMode::Lightweight)
+            {
+                ResetConveyorSubModel<ToteMode::Lightweight>(Ers::SubModel::Get(), scenario);
+            }
+            else
+            {
+                ResetConveyorSubModel<ToteMode::Entity>(Ers::SubModel::Get(), scenario);
+            }
+            simulator.ExitSubModel();
+        }
+
+        // The aggregators, if any, and the final simulator follow the lines
+        for (size_t i = lineSimulatorCount; i < simulators.size(); i++)
+        {
+            auto sinkSimulator = simulators[i];
+            sinkSimulator.EnterSubModel();
+            // Time-stepped lines always have lightweight totes
+            if (scenario.TimeSteppedLines || scenario.Mode == ToteMode::Lightweight)
+            {
+                ResetSink<ToteMode::Lightweight>(Ers::SubModel::Get());
+            }
+            else
+            {
+                ResetSink<ToteMode::Entity>(Ers::SubModel::Get());
+            }
+            sinkSimulator.ExitSubModel();
+        }
+
+        return true;
+    }
+
+    // Returns whether the conveyors of a model built with settings fit in the conveyor field of a tote log record
+    bool CanLogTotes(const ModelSettings& settings)
+    {
+        return settings.ConveyorCount >= 0 && static_cast<uint64_t>(settings.ConveyorCount) <= ToteLog::MaximumConveyor;
+    }
+
+    // Lets every simulator push its tote records into its own queue of writer, the aggregators and the final simulator use the queues
+    // after those of the lines. The chunks of a line log the conveyors of that line.
+    void AttachToteLog(Ers::ModelContainer& modelContainer, ToteLog::Writer& writer)
+    {
+        const std::vector<Ers::Simulator> simulators = modelContainer.GetSimulators();
+        for (size_t i = 0; i < simulators.size(); i++)
+        {
+            auto simulator = simulators[i];
+            simulator.EnterSubModel();
+            auto& submodel   = Ers::SubModel::Get();
+            auto& context    = submodel.GetSubModelContext<ToteLogContext>();
+            context.Line     = static_cast<uint32_t>(i);
+            context.Producer = &writer.GetProducer(i);
+
+            const EntityID statisticsEntity = submodel.FindEntity(SubModelStatistics::StatisticsEntityName);
+            if (statisticsEntity != Ers::Entity::InvalidEntity)
+            {
+                const auto statistics = submodel.GetComponent<SubModelStatistics>(statisticsEntity);
+                context.Line          = static_cast<uint32_t>(statistics->LineIndex);
+                context.FirstConveyor = statistics->FirstConveyorIndex;
+            }
+            simulator.ExitSubModel();
+        }
+    }
+
+    void DetachToteLog(Ers::ModelContainer& modelContainer)
+    {
+        for (auto simulator : modelContainer.GetSimulators())
+        {
+            simulator.EnterSubModel();
+            Ers::SubModel::Get().GetSubModelContext<ToteLogContext>().Producer = nullptr;
+            simulator.ExitSubModel();
+        }
+    }
+
+    // Outcome of a single benchmark run, used to compare model variants with each other
+    struct MeasureResult
+    {
+        uint64_t ReceivedTotes{0};
+        double Seconds{0.0};
+
+        // Indexed by conveyor simulator
+        std::vector<uint64_t> GeneratedTotes;
+        std::vector<uint64_t> MovedTotes;
+
+        // Delay or move events of the conveyors of event driven lines
+        uint64_t ScheduledConveyorEvents{0};
+        uint64_t PeakPendingConveyorEvents{0};
+
+        // Only counted when the run writes a tote log
+        uint64_t WrittenToteRecords{0};
+        uint64_t DroppedToteRecords{0};
+
+        // Promises of the lines to the final simulator after the one made while building, the lookahead in seconds
+        uint64_t SinkPromises{0};
+        double MeanSinkLookahead{0.0};
+
+        // Compares the simulation outcome, ignoring the wall clock time
+        bool HasSameStatistics(const MeasureResult& other) const
+        {
+            return ReceivedTotes == other.ReceivedTotes && GeneratedTotes == other.GeneratedTotes && MovedTotes == other.MovedTotes;
+        }
+    };
+
+    // Registers a conveyor behavior with the events that trigger it
+    template <typename Behavior>
+    void RegisterConveyorBehavior()
+    {
+        Ers::EventScheduler::RegisterLocalEvent<TriggerCreateToteEvent<Behavior>>();
+        Ers::EventScheduler::RegisterLocalEvent<TriggerDelayOrMoveEvent<Behavior>>();
+        Ers::EventScheduler::RegisterLocalEvent<TriggerWakeUpEvent<Behavior>>();
+        Ers::ComponentRegistry<Behavior>::Register();
+    }
+
+    template <ToteMode Mode>
+    void RegisterConveyorBehaviors()
+    {
+        RegisterConveyorBehavior<BasicConveyorScriptBehavior<Mode>>();
+        RegisterConveyorBehavior<SourceConveyorScriptBehavior<Mode, false>>();
+        RegisterConveyorBehavior<SourceConveyorScriptBehavior<Mode, true>>();
+        RegisterConveyorBehavior<IntermediateConveyorScriptBehavior<Mode, false>>();
+        RegisterConveyorBehavior<IntermediateConveyorScriptBehavior<Mode, true>>();
+        RegisterConveyorBehavior<FinalConveyorScriptBehavior<Mode, false>>();
+        RegisterConveyorBehavior<FinalConveyorScriptBehavior<Mode, true>>();
+        Ers::EventScheduler::RegisterSyncEvent<SendToFinalSubModelEventData<Mode>>();
+        Ers::EventScheduler::RegisterSyncEvent<HandOffToteEventData<Mode>>();
+    }
+
+    void RegisterTypes()
+    {
+        // Register event and component types before simulation starts
+        RegisterConveyorBehaviors<ToteMode::Entity>();
+        RegisterConveyorBehaviors<ToteMode::Lightweight>();
+
+        Ers::ComponentRegistry<SubModelStatistics>::Register();
+        Ers::ComponentRegistry<ConveyorPropertiesComponent>::Register();
+        Ers::ComponentRegistry<ToteIdentityComponent>::Register();
+        Ers::ComponentRegistry<SinkPropertiesComponent>::Register();
+        Ers::EventScheduler::RegisterSyncEvent<ForwardJoinedGroupEventData>();
+        Ers::EventScheduler::RegisterSyncEvent<ReturnCreditEventData>();
+
+        Ers::EventScheduler::RegisterLocalEvent<TriggerTimeStepEvent>();
+        Ers::ComponentRegistry<TimeSteppedLineComponent>::Register();
+    }
 
 } // namespace WealthOfRows
 
-void MeasureUser(int submodelCount, int conveyorCount, SimulationTime endTimeForModel, uint64_t chanceOfDelay)
+double SecondsSince(const std::chrono::high_resolution_clock::time_point& startTime)
 {
-    Ers::ModelManager& manager         = Ers::ModelManager::Get();
-    Ers::ModelContainer modelContainer = Ers::ModelContainer::Create();
-    modelContainer.SetPrecision(1'000'000);
+    const std::chrono::high_resolution_clock::time_point endTimePoint = std::chrono::high_resolution_clock::now();
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>((endTimePoint - startTime)).count()) / 1000;
+}
+
+// Simulation time units per second of every model built by BuildModel
+constexpr SimulationTime ModelPrecision = 1'000'000;
 
-    modelContainer.SetSeed(1);
+// Reports the progress of every run instead of the progress bar, once main opened it from ERS_METRICS
+ErsExamples::MetricsReporter RunMetrics;
 
-    Ers::Logger::Info(std::format("{}S_{}C_{}T_{}D", submodelCount, conveyorCount, endTimeForModel, chanceOfDelay));
+void BuildModel(Ers::ModelContainer& modelContainer, const WealthOfRows::ModelSettings& settings)
+{
+    modelContainer.SetPrecision(ModelPrecision);
+
+    modelContainer.SetSeed(settings.Seed);
+
+    Ers::Logger::Info(std::format(
+        "{}S_{}C_{}T_{}D{}{}{}{}{}", settings.SubmodelCount, settings.ConveyorCount, settings.EndTime, settings.ChanceOfDelay,
+        settings.Mode == WealthOfRows::ToteMode::Lightweight ? "_L" : "", settings.SpecializedConveyors ? "_P" : "",
+        settings.TimeSteppedLines ? "_T" : "", settings.AggregatorArity >= 2 ? std::format("_A{}", settings.AggregatorArity) : "",
+        WealthOfRows::LineChunkCount(settings) > 1 ? std::format("_K{}", WealthOfRows::LineChunkCount(settings)) : ""));
     Ers::Logger::Debug("Creating model...");
 
-    for (int i = 0; i < submodelCount; i++)
+    const uint64_t chunkCount = WealthOfRows::LineChunkCount(settings);
+    for (uint64_t chunk = 0; chunk < chunkCount; chunk++)
     {
-        WealthOfRows::CreateSubModel(modelContainer, conveyorCount, chanceOfDelay);
+        for (int i = 0; i < settings.SubmodelCount; i++)
+        {
+            if (settings.TimeSteppedLines)
+            {
+                WealthOfRows::CreateTimeSteppedSubModel(modelContainer, settings);
+            }
+            else
+            {
+                WealthOfRows::CreateSubModel(modelContainer, settings, i, chunk);
+            }
+        }
     }
-    WealthOfRows::CreateFinalSubModel(modelContainer);
+    for (uint64_t chunk = 1; chunk < chunkCount; chunk++)
+    {
+        for (int i = 0; i < settings.SubmodelCount; i++)
+        {
+            WealthOfRows::ConnectChunks(modelContainer, settings, i, chunk);
+        }
+    }
+    WealthOfRows::CreateFinalSubModel(modelContainer, settings);
+}
 
-#ifdef WOR_DEBUGGER
-    Ers::Debugger::Run(modelContainer);
-    return;
-#endif
+// Runs the model up to endTime, an absolute time of the model container, and collects the statistics of the run
+WealthOfRows::MeasureResult RunModel(
+    Ers::ModelContainer& modelContainer, const WealthOfRows::ModelSettings& settings, const SimulationTime endTime)
+{
+    WealthOfRows::MeasureResult result;
+
+    Ers::ModelManager& manager = Ers::ModelManager::Get();
 
     Ers::Logger::Debug("Starting...");
 
-    manager.AddModelContainer(modelContainer, endTimeForModel * modelContainer.GetPrecision());
+    manager.AddModelContainer(modelContainer, endTime);
+
+    if (RunMetrics.IsOpen())
+    {
+        ErsExamples::AttachMetrics(modelContainer, RunMetrics);
+    }
 
     Ers::Logger::Debug("Started!");
     const std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
 
-    manager.RunWithProgressBar();
+    WealthOfRows::AllocationAudit::SetPhase(WealthOfRows::AllocationAudit::Phase::Run);
+    if (RunMetrics.IsOpen())
+    {
+        // Headless, the samples of the metrics replace the progress bar
+        RunMetrics.Run(manager);
+    }
+    else
+    {
+        manager.RunWithProgressBar();
+    }
+    WealthOfRows::AllocationAudit::SetPhase(WealthOfRows::AllocationAudit::Phase::Teardown);
+
+    if (RunMetrics.IsOpen())
+    {
+        ErsExamples::DetachMetrics(modelContainer);
+    }
+
+    result.Seconds = SecondsSince(startTime);
 
-    const std::chrono::high_resolution_clock::time_point endTimePoint = std::chrono::high_resolution_clock::now();
     auto finalSimulator = modelContainer.GetSimulators().at(modelContainer.GetSimulators().size() - 1);
     finalSimulator.EnterSubModel();
     auto& finalSubmodel = Ers::SubModel::Get();
 
     const EntityID sinkEntity = finalSubmodel.FindEntity("Sink");
     auto sinkProperties       = finalSubmodel.GetComponent<WealthOfRows::SinkPropertiesComponent>(sinkEntity);
+    result.ReceivedTotes      = sinkProperties->ReceivedTotes;
 
     Ers::Logger::Info(
-        std::format("{} received totes", sinkProperties->ReceivedTotes) + " " +
-        std::format(
-            "{} s",
-            std::to_string(
-                static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>((endTimePoint - startTime)).count()) / 1000)));
+        std::format("{} received totes", sinkProperties->ReceivedTotes) + " " + std::format("{} s", std::to_string(result.Seconds)));
     finalSimulator.ExitSubModel();
 
-    for (int i = 0; i < submodelCount; i++)
+    ErsExamples::LookaheadPromise sinkPromises;
+    const std::vector<Ers::Simulator> simulators = modelContainer.GetSimulators();
+    for (size_t i = 0; i < WealthOfRows::LineSimulatorCount(settings); i++)
     {
-        auto simulator = modelContainer.GetSimulators()[i];
+        auto simulator = simulators[i];
         simulator.EnterSubModel();
-        auto& conveyorSubmodel = Ers::SubModel::Get();
-        auto statisticsEntity  = conveyorSubmodel.FindEntity(WealthOfRows::SubModelStatistics::StatisticsEntityName);
-        auto statistics        = conveyorSubmodel.GetComponent<WealthOfRows::SubModelStatistics>(statisticsEntity);
+        uint64_t generatedTotes = 0;
+        uint64_t movedTotes     = 0;
+        WealthOfRows::GetLineCounters(Ers::SubModel::Get(), generatedTotes, movedTotes);
+        // Time-stepped lines have a single event per step instead
+        if (!settings.TimeSteppedLines && settings.Mode == WealthOfRows::ToteMode::Lightweight)
+        {
+            WealthOfRows::AddConveyorEventCounters<WealthOfRows::ToteMode::Lightweight>(
+                Ers::SubModel::Get(), result.ScheduledConveyorEvents, result.PeakPendingConveyorEvents);
+        }
+        else if (!settings.TimeSteppedLines)
+        {
+            WealthOfRows::AddConveyorEventCounters<WealthOfRows::ToteMode::Entity>(
+                Ers::SubModel::Get(), result.ScheduledConveyorEvents, result.PeakPendingConveyorEvents);
+        }
+
+        // Time-stepped lines always have lightweight totes
+        if (settings.TimeSteppedLines || settings.Mode == WealthOfRows::ToteMode::Lightweight)
+        {
+            WealthOfRows::AddSinkPromiseCounters<WealthOfRows::ToteMode::Lightweight>(Ers::SubModel::Get(), sinkPromises);
+        }
+        else
+        {
+            WealthOfRows::AddSinkPromiseCounters<WealthOfRows::ToteMode::Entity>(Ers::SubModel::Get(), sinkPromises);
+        }
+
         Ers::Logger::Info(std::format(
-            "[{}] Totes generated: {}, Moved: {}", simulator.GetName(), statistics->NumberOfGeneratedEntities,
-            statistics->NumberOfGeneratedEntities - (statistics->NumberOfMovedEntities / conveyorCount)));
-        conveyorSubmodel.DestroyEntity(statisticsEntity);
+            "[{}] Totes generated: {}, moves between conveyors: {}", simulator.GetName(), generatedTotes, movedTotes));
+        result.GeneratedTotes.push_back(generatedTotes);
+        result.MovedTotes.push_back(movedTotes);
         simulator.ExitSubModel();
     }
 
+    result.SinkPromises      = sinkPromises.Promises;
+    result.MeanSinkLookahead = sinkPromises.MeanLookahead() / static_cast<double>(modelContainer.GetPrecision());
+    if (settings.AutomaticPromises)
+    {
+        Ers::Logger::Info(
+            std::format("{} promises to the final simulator, mean lookahead {:.3f} s", result.SinkPromises, result.MeanSinkLookahead));
+    }
+
     std::cout << "\n";
 
+    return result;
+}
+
+uint64_t TotalGeneratedTotes(const WealthOfRows::MeasureResult& result)
+{
+    return std::accumulate(result.GeneratedTotes.begin(), result.GeneratedTotes.end(), uint64_t(0));
+}
+
+WealthOfRows::MeasureResult BuildAndRunModel(const WealthOfRows::ModelSettings& settings)
+{
+    // Declared before the model container, so the queues outlive the simulators that push into them
+    WealthOfRows::ToteLog::Writer toteLog;
+
+    Ers::ModelContainer modelContainer = Ers::ModelContainer::Create();
+    BuildModel(modelContainer, settings);
+
+#ifdef WOR_DEBUGGER
+    Ers::Debugger::Run(modelContainer);
+    return {};
+#endif
+
+    // One queue for every simulator, the aggregators and the final simulator included
+    if (!settings.ToteLogPath.empty() && !WealthOfRows::CanLogTotes(settings))
+    {
+        Ers::Logger::Info(std::format("[Tote log] Can't log lines of more than {} conveyors", WealthOfRows::ToteLog::MaximumConveyor));
+    }
+    else if (!settings.ToteLogPath.empty() && toteLog.Open(settings.ToteLogPath, modelContainer.GetSimulators().size()))
+    {
+        WealthOfRows::AttachToteLog(modelContainer, toteLog);
+    }
+
+    WealthOfRows::MeasureResult result = RunModel(modelContainer, settings, settings.EndTime * modelContainer.GetPrecision());
+
+    if (toteLog.IsOpen())
+    {
+        WealthOfRows::DetachToteLog(modelContainer);
+        toteLog.Close();
+        result.WrittenToteRecords = toteLog.WrittenRecords();
+        result.DroppedToteRecords = toteLog.DroppedRecords();
+        Ers::Logger::Info(std::format(
+            "[Tote log] {} records written to {}, {} dropped", result.WrittenToteRecords, settings.ToteLogPath,
+            result.DroppedToteRecords));
+    }
+
+    const std::vector<Ers::Simulator> simulators = modelContainer.GetSimulators();
+    for (size_t i = 0; i < WealthOfRows::LineSimulatorCount(settings); i++)
+    {
+        auto simulator = simulators[i];
+        simulator.EnterSubModel();
+        auto& conveyorSubmodel = Ers::SubModel::Get();
+        conveyorSubmodel.DestroyEntity(conveyorSubmodel.FindEntity(
+            settings.TimeSteppedLines ? WealthOfRows::TimeSteppedLineComponent::LineEntityName
+                                      : WealthOfRows::SubModelStatistics::StatisticsEntityName));
+        simulator.ExitSubModel();
+    }
+
     Ers::Logger::Debug("Destroying model...");
+    return result;
 }
 
-void MeasureUser(
-    const int& submodelCount, const int& conveyorCount, const SimulationTime endTimeForModel, uint64_t chanceOfDelay, uint64_t amountOfRuns)
+WealthOfRows::MeasureResult MeasureUser(const WealthOfRows::ModelSettings& settings)
 {
-    for (size_t i = 0; i < amountOfRuns; i++)
+    WealthOfRows::AllocationAudit::Reset();
+    WealthOfRows::AllocationAudit::SetPhase(WealthOfRows::AllocationAudit::Phase::Build);
+
+    // The model container is destroyed when BuildAndRunModel returns, which still counts as teardown
+    const WealthOfRows::MeasureResult result = BuildAndRunModel(settings);
+
+    WealthOfRows::AllocationAudit::SetPhase(WealthOfRows::AllocationAudit::Phase::Idle);
+    WealthOfRows::AllocationAudit::Report(TotalGeneratedTotes(result));
+    return result;
+}
+
+// Runs the scenarios one after the other on a single built model, resetting it between the runs. When the model can't be reset to
+// a scenario, it is torn down and the scenario gets a newly built model, which the following scenarios are reset from.
+std::vector<WealthOfRows::MeasureResult> RunScenarios(const std::vector<WealthOfRows::ModelSettings>& scenarios)
+{
+    std::vector<WealthOfRows::MeasureResult> results;
+    size_t next = 0;
+    while (next < scenarios.size())
     {
-        MeasureUser(submodelCount, conveyorCount, endTimeForModel, chanceOfDelay);
+        WealthOfRows::AllocationAudit::SetPhase(WealthOfRows::AllocationAudit::Phase::Build);
+        const WealthOfRows::ModelSettings& builtSettings = scenarios[next];
+        Ers::ModelContainer modelContainer                = Ers::ModelContainer::Create();
+        BuildModel(modelContainer, builtSettings);
+
+        // The clock of the model container continues after a reset, so every run ends one run length later
+        SimulationTime endTime(0);
+        for (; next < scenarios.size(); next++)
+        {
+            const WealthOfRows::ModelSettings& scenario = scenarios[next];
+            if (endTime > 0)
+            {
+                WealthOfRows::AllocationAudit::SetPhase(WealthOfRows::AllocationAudit::Phase::Reset);
+                if (!WealthOfRows::ResetModel(modelContainer, builtSettings, scenario))
+                {
+                    Ers::Logger::Info(std::format("Scenario {} can't be reset to, rebuilding the model", next));
+                    WealthOfRows::AllocationAudit::SetPhase(WealthOfRows::AllocationAudit::Phase::Teardown);
+                    break;
+                }
+            }
+
+            endTime += scenario.EndTime * modelContainer.GetPrecision();
+            results.push_back(RunModel(modelContainer, scenario, endTime));
+        }
+
+        Ers::Logger::Debug("Destroying model...");
     }
+    return results;
 }
-int main()
+
+// Builds the model once and runs it amountOfRuns times, resetting it with the next seed between the runs
+std::vector<WealthOfRows::MeasureResult> MeasureUser(const WealthOfRows::ModelSettings& settings, uint64_t amountOfRuns)
 {
-    Ers::Initialize();
+    WealthOfRows::AllocationAudit::Reset();
 
-    // Register event types before simulation starts
-    Ers::EventScheduler::RegisterLocalEvent<WealthOfRows::TriggerCreateToteEvent>();
-    Ers::EventScheduler::RegisterLocalEvent<WealthOfRows::TriggerDelayOrMoveEvent>();
-    Ers::EventScheduler::RegisterSyncEvent<WealthOfRows::SendToFinalSubModelEventData>();
+    std::vector<WealthOfRows::ModelSettings> scenarios(amountOfRuns, settings);
+    for (uint64_t i = 0; i < amountOfRuns; i++)
+    {
+        scenarios[i].Seed += i;
+    }
+    const std::vector<WealthOfRows::MeasureResult> results = RunScenarios(scenarios);
+
+    uint64_t generatedTotes = 0;
+    for (const WealthOfRows::MeasureResult& result : results)
+    {
+        generatedTotes += TotalGeneratedTotes(result);
+    }
+
+    WealthOfRows::AllocationAudit::SetPhase(WealthOfRows::AllocationAudit::Phase::Idle);
+    WealthOfRows::AllocationAudit::Report(generatedTotes);
+    return results;
+}
+
+// Runs the same model with entity totes and with lightweight totes, and checks that both produce the same statistics
+void CompareToteModes(WealthOfRows::ModelSettings settings)
+{
+    settings.Mode                                 = WealthOfRows::ToteMode::Entity;
+    const WealthOfRows::MeasureResult entityTotes = MeasureUser(settings);
+
+    settings.Mode                                      = WealthOfRows::ToteMode::Lightweight;
+    const WealthOfRows::MeasureResult lightweightTotes = MeasureUser(settings);
+
+    Ers::Logger::Info(std::format(
+        "Entity totes: {:.3f} s, lightweight totes: {:.3f} s ({:.2f}x), statistics {}", entityTotes.Seconds, lightweightTotes.Seconds,
+        entityTotes.Seconds / lightweightTotes.Seconds, entityTotes.HasSameStatistics(lightweightTotes) ? "match" : "DIFFER"));
+}
+
+// Runs the model with the generic conveyor behavior and with the specialized conveyor behaviors, for lines with and without delays,
+// with entity and with lightweight totes
+void CompareConveyorPolicies(WealthOfRows::ModelSettings settings)
+{
+    const uint64_t chanceOfDelays[] = {settings.ChanceOfDelay, 0};
+    for (const WealthOfRows::ToteMode mode : {WealthOfRows::ToteMode::Entity, WealthOfRows::ToteMode::Lightweight})
+    {
+        for (const uint64_t chanceOfDelay : chanceOfDelays)
+        {
+            settings.Mode          = mode;
+            settings.ChanceOfDelay = chanceOfDelay;
+
+            settings.SpecializedConveyors             = false;
+            const WealthOfRows::MeasureResult generic = MeasureUser(settings);
+
+            settings.SpecializedConveyors                 = true;
+            const WealthOfRows::MeasureResult specialized = MeasureUser(settings);
+
+            Ers::Logger::Info(std::format(
+                "{} totes, chance of delay {}: generic {:.3f} s, specialized {:.3f} s ({:.2f}x), statistics {}",
+                mode == WealthOfRows::ToteMode::Entity ? "Entity" : "Lightweight", chanceOfDelay, generic.Seconds, specialized.Seconds,
+                generic.Seconds / specialized.Seconds, generic.HasSameStatistics(specialized) ? "match" : "DIFFER"));
+        }
+    }
+}
+
+// Runs a sweep of short scenarios, once rebuilding the model for every scenario and once resetting a single built model
+void CompareRebuildAndReset(WealthOfRows::ModelSettings settings)
+{
+    const uint64_t amountOfRuns = 100;
+    settings.EndTime            = SimulationTime(600);
+
+    std::vector<WealthOfRows::MeasureResult> rebuildResults;
+    const std::chrono::high_resolution_clock::time_point rebuildStartTime = std::chrono::high_resolution_clock::now();
+    for (uint64_t i = 0; i < amountOfRuns; i++)
+    {
+        WealthOfRows::ModelSettings scenario = settings;
+        scenario.Seed += i;
+        rebuildResults.push_back(MeasureUser(scenario));
+    }
+    const double rebuildSeconds = SecondsSince(rebuildStartTime);
+
+    const std::chrono::high_resolution_clock::time_point resetStartTime = std::chrono::high_resolution_clock::now();
+    const std::vector<WealthOfRows::MeasureResult> resetResults = MeasureUser(settings, amountOfRuns);
+    const double resetSeconds                                   = SecondsSince(resetStartTime);
+
+    // Every conveyor reseeds its own random streams on reset, so a reset run repeats the rebuilt run with the same seed
+    bool sameStatistics = true;
+    for (uint64_t i = 0; i < amountOfRuns; i++)
+    {
+        sameStatistics = sameStatistics && rebuildResults[i].HasSameStatistics(resetResults[i]);
+    }
+
+    Ers::Logger::Info(std::format(
+        "{} scenarios: rebuilding {:.3f} s, resetting {:.3f} s ({:.2f}x), statistics {}", amountOfRuns, rebuildSeconds, resetSeconds,
+        rebuildSeconds / resetSeconds, sameStatistics ? "match" : "DIFFER"));
+}
+
+// Estimates the effect of a higher chance of delay on the received totes from paired replications. Once with common random numbers,
+// where both scenarios of a pair use the same seed, and once with independent seeds, to compare the variance of the difference.
+void CompareCommonRandomNumbers(WealthOfRows::ModelSettings settings)
+{
+    const uint64_t replications = 20;
+    settings.EndTime            = SimulationTime(3600);
+
+    WealthOfRows::ModelSettings alternative = settings;
+    alternative.ChanceOfDelay += 5;
+
+    // Every replication is a baseline run, an alternative run with the same seed and an alternative run with an independent seed
+    std::vector<WealthOfRows::ModelSettings> scenarios;
+    for (uint64_t i = 0; i < replications; i++)
+    {
+        scenarios.push_back(settings);
+        scenarios.back().Seed = settings.Seed + i;
+        scenarios.push_back(alternative);
+        scenarios.back().Seed = settings.Seed + i;
+        scenarios.push_back(alternative);
+        scenarios.back().Seed = settings.Seed + replications + i;
+    }
+    const std::vector<WealthOfRows::MeasureResult> results = RunScenarios(scenarios);
+
+    std::vector<double> commonDifferences;
+    std::vector<double> independentDifferences;
+    for (uint64_t i = 0; i < replications; i++)
+    {
+        const double baseline = static_cast<double>(results[3 * i].ReceivedTotes);
+        commonDifferences.push_back(static_cast<double>(results[3 * i + 1].ReceivedTotes) - baseline);
+        independentDifferences.push_back(static_cast<double>(results[3 * i + 2].ReceivedTotes) - baseline);
+    }
+
+    auto meanAndVariance = [](const std::vector<double>& values)
+    {
+        const double mean = std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size());
+        double variance   = 0.0;
+        for (const double value : values)
+        {
+            variance += (value - mean) * (value - mean);
+        }
+        return std::pair<double, double>(mean, variance / static_cast<double>(values.size() - 1));
+    };
+
+    const auto [commonMean, commonVariance]           = meanAndVariance(commonDifferences);
+    const auto [independentMean, independentVariance] = meanAndVariance(independentDifferences);
+
+    // The number of replications needed for the same confidence scales with the variance of the difference
+    Ers::Logger::Info(std::format(
+        "Chance of delay {} -> {}, {} replications: common random numbers {:.1f} totes (variance {:.1f}), independent seeds {:.1f} "
+        "totes (variance {:.1f}), variance reduction {:.2f}x",
+        settings.ChanceOfDelay, alternative.ChanceOfDelay, replications, commonMean, commonVariance, independentMean,
+        independentVariance, commonVariance > 0.0 ? independentVariance / commonVariance : 0.0));
+}
+
+// Runs dense lines event by event and time-stepped, and compares the runtime. The time-stepped lines fill a freed segment one step
+// later than the event driven lines do, so their throughput is close to, but not the same as, that of the event driven lines.
+void CompareTimeSteppedLines(WealthOfRows::ModelSettings settings)
+{
+    settings.ConveyorCount = 200;
+    settings.ChanceOfDelay = 0;
+    settings.EndTime       = SimulationTime(3600);
+    settings.Mode          = WealthOfRows::ToteMode::Lightweight;
+
+    settings.TimeSteppedLines                      = false;
+    const WealthOfRows::MeasureResult eventDriven = MeasureUser(settings);
+
+    settings.TimeSteppedLines                     = true;
+    const WealthOfRows::MeasureResult timeStepped = MeasureUser(settings);
+
+    Ers::Logger::Info(std::format(
+        "Event driven lines: {:.3f} s, {} received totes, time-stepped lines ({} s steps): {:.3f} s, {} received totes ({:.2f}x)",
+        eventDriven.Seconds, eventDriven.ReceivedTotes, settings.StepSeconds, timeStepped.Seconds, timeStepped.ReceivedTotes,
+        eventDriven.Seconds / timeStepped.Seconds));
+}
+
+// Runs lines of high-capacity conveyors with an event per tote and with bundled events per conveyor, and compares the runtime and
+// the number of events. Totes that are due at the same time on different conveyors can be processed in a different order.
+// The bundled lines also run with lightweight totes, which must produce the same statistics as entity totes at this capacity too.
+void CompareEventBundling(WealthOfRows::ModelSettings settings)
+{
+    settings.ConveyorCapacity    = 64;
+    settings.ConveyorMinimumTime = 60;
+    settings.EndTime             = SimulationTime(3600 * 4);
+    settings.Mode                = WealthOfRows::ToteMode::Entity;
+
+    settings.BundleConveyorEvents              = false;
+    const WealthOfRows::MeasureResult perTote = MeasureUser(settings);
+
+    settings.BundleConveyorEvents              = true;
+    const WealthOfRows::MeasureResult bundled = MeasureUser(settings);
+
+    settings.Mode                                         = WealthOfRows::ToteMode::Lightweight;
+    const WealthOfRows::MeasureResult bundledLightweight = MeasureUser(settings);
+
+    Ers::Logger::Info(std::format(
+        "Event per tote: {:.3f} s, {} events, at most {} pending per conveyor; bundled: {:.3f} s, {} events, at most {} pending per "
+        "conveyor ({:.2f}x), statistics {}",
+        perTote.Seconds, perTote.ScheduledConveyorEvents, perTote.PeakPendingConveyorEvents, bundled.Seconds,
+        bundled.ScheduledConveyorEvents, bundled.PeakPendingConveyorEvents, perTote.Seconds / bundled.Seconds,
+        perTote.HasSameStatistics(bundled) ? "match" : "DIFFER"));
+    Ers::Logger::Info(std::format(
+        "Capacity {}: entity totes and lightweight totes, statistics {}", settings.ConveyorCapacity,
+        bundled.HasSameStatistics(bundledLightweight) ? "match" : "DIFFER"));
+}
+
+// Runs the model without and with a tote log, compares the runtime and summarizes the sojourn times from the log
+void CompareToteLog(WealthOfRows::ModelSettings settings)
+{
+    if (!WealthOfRows::CanLogTotes(settings))
+    {
+        Ers::Logger::Info(std::format("[Tote log] Can't log lines of more than {} conveyors", WealthOfRows::ToteLog::MaximumConveyor));
+        return;
+    }
 
-    // Register component types
-    Ers::ComponentRegistry<WealthOfRows::SubModelStatistics>::Register();
-    Ers::ComponentRegistry<WealthOfRows::ConveyorPropertiesComponent>::Register();
-    Ers::ComponentRegistry<WealthOfRows::ConveyorScriptBehavior>::Register();
-    Ers::ComponentRegistry<WealthOfRows::SinkPropertiesComponent>::Register();
+    settings.ToteLogPath                         = "";
+    const WealthOfRows::MeasureResult withoutLog = MeasureUser(settings);
+
+    settings.ToteLogPath                      = "tote_log.bin";
+    const WealthOfRows::MeasureResult withLog = MeasureUser(settings);
+
+    Ers::Logger::Info(std::format(
+        "Without tote log: {:.3f} s, with tote log: {:.3f} s ({:.2f}x), statistics {}", withoutLog.Seconds, withLog.Seconds,
+        withLog.Seconds / withoutLog.Seconds, withoutLog.HasSameStatistics(withLog) ? "match" : "DIFFER"));
+
+    // A dropped record leaves its tote without a pair, which would bias the means towards the totes that are complete
+    if (withLog.DroppedToteRecords > 0)
+    {
+        Ers::Logger::Info(std::format(
+            "[Tote log] {} records were dropped, the sojourn times are not summarized, the log is incomplete", withLog.DroppedToteRecords));
+        return;
+    }
+
+    WealthOfRows::ToteLog::SojournSummary summary;
+    if (!WealthOfRows::ToteLog::SummarizeSojournTimes(
+            settings.ToteLogPath, static_cast<uint32_t>(settings.SubmodelCount), static_cast<uint16_t>(settings.ConveyorCount),
+            ModelPrecision, summary))
+    {
+        return;
+    }
+
+    Ers::Logger::Info(std::format(
+        "[Tote log] {} records, {} joined totes: {:.3f} s in line, {:.3f} s waiting at the sink, {:.3f} s in total", summary.Records,
+        summary.JoinedTotes, summary.MeanTimeInLine, summary.MeanWaitAtSink, summary.MeanTotalTime));
+    for (size_t i = 0; i < summary.MeanTimeOnConveyor.size(); i++)
+    {
+        Ers::Logger::Info(std::format("[Tote log] Conveyor {}: {:.3f} s", i, summary.MeanTimeOnConveyor[i]));
+    }
+}
+
+// Runs the model with the static promise of the sync delay and with automatic promises, and compares the runtime. Promises
+// only let the final simulator run ahead, so the statistics must be the same.
+void ComparePromises(WealthOfRows::ModelSettings settings)
+{
+    settings.AutomaticPromises                       = false;
+    const WealthOfRows::MeasureResult staticPromise = MeasureUser(settings);
+
+    settings.AutomaticPromises                           = true;
+    const WealthOfRows::MeasureResult automaticPromises = MeasureUser(settings);
+
+    Ers::Logger::Info(std::format(
+        "Static promises: {:.3f} s, lookahead {} s; automatic promises: {:.3f} s, {} promises, mean lookahead {:.3f} s ({:.2f}x), "
+        "statistics {}",
+        staticPromise.Seconds, WealthOfRows::SinkSyncDelay, automaticPromises.Seconds, automaticPromises.SinkPromises,
+        automaticPromises.MeanSinkLookahead, staticPromise.Seconds / automaticPromises.Seconds,
+        staticPromise.HasSameStatistics(automaticPromises) ? "match" : "DIFFER"));
+}
+
+// Runs the model with the lines sending to the final simulator directly and through aggregator trees of several arities, and compares
+// the throughput. Every level of aggregators delays the totes by a sync delay, so the totes received just before the end can differ.
+void CompareAggregatorArities(WealthOfRows::ModelSettings settings)
+{
+    for (const uint64_t arity : {0, 2, 4, 8, 16})
+    {
+        settings.AggregatorArity                 = arity;
+        const WealthOfRows::MeasureResult result = MeasureUser(settings);
+
+        Ers::Logger::Info(std::format(
+            "{}: {:.3f} s, {} received totes, {:.0f} totes/s", arity >= 2 ? std::format("Arity {}", arity) : std::string("Direct"),
+            result.Seconds, result.ReceivedTotes, static_cast<double>(result.ReceivedTotes) / result.Seconds));
+    }
+}
+
+// Runs one long line unpartitioned and split into chunks across several simulators, and compares the throughput. Every hand-off
+// between chunks takes a sync delay, so the totes received just before the end can differ from those of the unpartitioned line.
+void CompareLineChunks(WealthOfRows::ModelSettings settings)
+{
+    settings.SubmodelCount = 1;
+    settings.ConveyorCount = 2000;
+    settings.EndTime       = SimulationTime(3600);
+    settings.Mode          = WealthOfRows::ToteMode::Lightweight;
+
+    WealthOfRows::MeasureResult unpartitioned;
+    for (const uint64_t chunks : {1, 2, 4, 8})
+    {
+        settings.LineChunks                      = chunks;
+        const WealthOfRows::MeasureResult result = MeasureUser(settings);
+        if (chunks == 1)
+        {
+            unpartitioned = result;
+        }
+
+        const uint64_t movedTotes = std::accumulate(result.MovedTotes.begin(), result.MovedTotes.end(), uint64_t(0));
+        const uint64_t unpartitionedMovedTotes =
+            std::accumulate(unpartitioned.MovedTotes.begin(), unpartitioned.MovedTotes.end(), uint64_t(0));
+        Ers::Logger::Info(std::format(
+            "{} chunks: {:.3f} s ({:.2f}x), {} received totes, {} generated, {} moved, {} unpartitioned", chunks, result.Seconds,
+            unpartitioned.Seconds / result.Seconds, result.ReceivedTotes, TotalGeneratedTotes(result), movedTotes,
+            result.ReceivedTotes == unpartitioned.ReceivedTotes && TotalGeneratedTotes(result) == TotalGeneratedTotes(unpartitioned) &&
+                    movedTotes == unpartitionedMovedTotes
+                ? "matches"
+                : "DIFFERS from"));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Ers::Initialize();
+
+    WealthOfRows::RegisterTypes();
 
     // Benchmark settings
-    const int submodelCount = 50;
-    const int conveyorCount = 10;
-    const int chanceOfDelay = 3;
-    SimulationTime endTimeForModel(86400);
+    WealthOfRows::ModelSettings settings;
+    settings.SubmodelCount = 50;
+    settings.ConveyorCount = 10;
+    settings.ChanceOfDelay = 3;
+    settings.EndTime       = SimulationTime(86400);
+
+    // Reports to a stats file or a Unix socket instead of showing the progress bar, for runs without a terminal
+    const std::string metricsTarget = ErsExamples::MetricsReporter::TargetFromEnvironment();
+    if (!metricsTarget.empty() && !RunMetrics.Open(metricsTarget, ErsExamples::MetricsReporter::IntervalFromEnvironment()))
+    {
+        Ers::Logger::Info(std::format("Can't open metrics target {}", metricsTarget));
+    }
 
-    for (int i = 0; i < 1; i++)
-        MeasureUser(submodelCount, conveyorCount, endTimeForModel, chanceOfDelay);
+    // Optional first argument selects a comparison benchmark instead of the default measurement
+    const std::string_view benchmark = argc > 1 ? argv[1] : "";
+    if (benchmark == "tote-modes")
+    {
+        CompareToteModes(settings);
+    }
+    else if (benchmark == "policies")
+    {
+        CompareConveyorPolicies(settings);
+    }
+    else if (benchmark == "reset")
+    {
+        CompareRebuildAndReset(settings);
+    }
+    else if (benchmark == "crn")
+    {
+        CompareCommonRandomNumbers(settings);
+    }
+    else if (benchmark == "tote-log")
+    {
+        CompareToteLog(settings);
+    }
+    else if (benchmark == "time-stepped")
+    {
+        CompareTimeSteppedLines(settings);
+    }
+    else if (benchmark == "bundling")
+    {
+        CompareEventBundling(settings);
+    }
+    else if (benchmark == "promises")
+    {
+        ComparePromises(settings);
+    }
+    else if (benchmark == "fan-in")
+    {
+        CompareAggregatorArities(settings);
+    }
+    else if (benchmark == "chunks")
+    {
+        CompareLineChunks(settings);
+    }
+    else if (benchmark == "lightweight")
+    {
+        settings.Mode = WealthOfRows::ToteMode::Lightweight;
+        MeasureUser(settings);
+    }
+    else
+    {
+        for (int i = 0; i < 1; i++)
+            MeasureUser(settings);
+    }
 
+    RunMetrics.Close();
     Ers::Uninitialize();
     return 0;
 }
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "Ers/SubModel/EventScheduler.h"
+
+namespace ErsExamples
+{
+    // Keeps the promise of a simulator to one of the simulators that depend on it (an AddSimulatorDependency edge) up to date.
+    // A promise tells the target that the sender schedules no sync event for it that arrives within the lookahead from the current
+    // time of the sender, so the target can advance that far without waiting for the sender.
+    //
+    // A promise is relative to the time of the sender and stays in effect until the sender replaces it. The time of the sender
+    // advances with every one of its events, the sender side of its sync events included. So a promise must hold at every time the
+    // sender reaches before it replaces the promise, not only at the time it was made.
+    //
+    // The lookahead of an edge is the smallest delay of the sync events on it, plus the time until the sender can schedule its
+    // next sync event at the earliest, as passed to Update. Ways to keep a promise valid while the sender's time advances:
+    // - Pass a time that holds at any time while the state it is derived from lasts, and update the promise whenever that state
+    //   changes. For example, a conveyor that holds no tote can't send before a tote has entered and stayed its minimum time.
+    // - Update the promise in every event of the sender, with the time from that event until the next send.
+    // - Update the promise in a periodic event of the sender, with the time until the next send counted from the next of these
+    //   events, so that it also holds at the times of the other events in between.
+    // When none of these applies, pass zero to promise only the sync delay, which always holds.
+    class LookaheadPromise
+    {
+      public:
+        // Time until the next sync event when the sender will never send one again
+        static constexpr SimulationTime Unbounded = std::numeric_limits<SimulationTime>::max() / 4;
+
+        LookaheadPromise() = default;
+        explicit LookaheadPromise(SimulationTime minimumSyncDelay) : MinimumSyncDelay(minimumSyncDelay) {}
+
+        // Must be called from within the submodel of the sender
+        void Update(uint32_t targetSimulatorId, SimulationTime timeUntilNextSend)
+        {
+            const SimulationTime lookahead = MinimumSyncDelay + std::clamp<SimulationTime>(timeUntilNextSend, 0, Unbounded);
+            Ers::EventScheduler::SetPromise(targetSimulatorId, lookahead);
+
+            Promises++;
+            if (timeUntilNextSend < Unbounded)
+            {
+                BoundedPromises++;
+                TotalLookahead += lookahead;
+            }
+        }
+
+        // Adds the statistics of other, to summarize the promises of several edges
+        void Add(const LookaheadPromise& other)
+        {
+            Promises += other.Promises;
+            BoundedPromises += other.BoundedPromises;
+            TotalLookahead += other.TotalLookahead;
+        }
+
+        // Mean promised lookahead, promises that the sender will never send again are left out
+        double MeanLookahead() const
+        {
+            return BoundedPromises == 0 ? 0.0 : static_cast<double>(TotalLookahead) / static_cast<double>(BoundedPromises);
+        }
+
+        SimulationTime MinimumSyncDelay{0};
+
+        uint64_t Promises{0};
+        uint64_t BoundedPromises{0};
+        SimulationTime TotalLookahead{0};
+    };
+} // namespace ErsExamples
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "Ers/Model/ModelContainer.h"
+#include "Ers/Model/ModelManager.h"
+#include "Ers/Model/Simulator/Simulator.h"
+#include "Ers/SubModel/SubModel.h"
+
+namespace ErsExamples
+{
+    // Progress counters of one simulator. Only the thread that runs the simulator writes them, with a relaxed load and store instead
+    // of an atomic read-modify-write, so counting an event costs as much as a plain increment. The reporter thread reads them.
+    // Aligned to a cache line, so simulators that run on different threads never write to the same line.
+    struct alignas(64) SimulatorMetrics
+    {
+        std::atomic<SimulationTime> Now{0};
+        std::atomic<uint64_t> Events{0};
+        std::atomic<uint64_t> Delivered{0};
+
+        void CountEvent(SimulationTime now)
+        {
+            Now.store(now, std::memory_order_relaxed);
+            Events.store(Events.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        void CountDelivered(uint64_t count)
+        {
+            Delivered.store(Delivered.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        }
+    };
+
+    // Submodel context for models that have no context of their own to hold the metrics of their simulator, see AttachMetrics
+    struct MetricsContext
+    {
+        SimulatorMetrics* Metrics{nullptr};
+    };
+
+    // Reports the progress of headless runs without a progress bar. A thread samples the SimulatorMetrics of every simulator at a
+    // fixed wall-clock interval and writes one line per sample to a stats file, or to every client of a local Unix socket:
+    //
+    //   wall_s=2.000 sim_time_s=3512.250 max_sim_time_s=3600.000 events=1204311 events_per_s=598812 delivered=2450
+    //   delivered_per_s=1210 events_by_simulator=2377,...
+    //
+    // all on one line. sim_time_s is the time of the simulator that is furthest behind, and the rates are over the last interval.
+    // Every run starts with comment lines, starting with #, that list its simulators, and ends with a sample at its end.
+    class MetricsReporter
+    {
+      public:
+        MetricsReporter() = default;
+        MetricsReporter(const MetricsReporter&)            = delete;
+        MetricsReporter& operator=(const MetricsReporter&) = delete;
+        ~MetricsReporter() { Close(); }
+
+        // The target of the ERS_METRICS environment variable and the interval of ERS_METRICS_INTERVAL_MS, one second by default,
+        // so a job script can enable the reporting without changing the arguments of an example
+        static std::string TargetFromEnvironment()
+        {
+            const char* target = std::getenv("ERS_METRICS");
+            return target != nullptr ? target : "";
+        }
+
+        static std::chrono::milliseconds IntervalFromEnvironment()
+        {
+            const char* interval = std::getenv("ERS_METRICS_INTERVAL_MS");
+            const long long milliseconds = interval != nullptr ? std::atoll(interval) : 0;
+            return std::chrono::milliseconds(milliseconds > 0 ? milliseconds : 1000);
+        }
+
+        // target is the path of a stats file, which is appended to, or unix:<path> to listen on a Unix socket.
+        // Returns false when the target can't be opened, Unix sockets are not supported on Windows.
+        bool Open(const std::string& target, std::chrono::milliseconds interval)
+        {
+            Close();
+            Interval = interval;
+
+            constexpr std::string_view socketPrefix = "unix:";
+            if (!target.starts_with(socketPrefix))
+            {
+                File = std::fopen(target.c_str(), "a");
+                return File != nullptr;
+            }
+
+#ifdef _WIN32
+            return false;
+#else
+            SocketPath = target.substr(socketPrefix.size());
+
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (SocketPath.empty() || SocketPath.size() >= sizeof(address.sun_path))
+            {
+                return false;
+            }
+            SocketPath.copy(address.sun_path, SocketPath.size());
+
+            ListenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (ListenSocket < 0)
+            {
+                return false;
+            }
+
+            // A socket file left behind by an earlier run would make bind fail
+            unlink(SocketPath.c_str());
+            if (bind(ListenSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(ListenSocket, 8) != 0)
+            {
+                close(ListenSocket);
+                ListenSocket = -1;
+                return false;
+            }
+
+            // The reporter thread accepts new clients before every sample, without waiting for them
+            fcntl(ListenSocket, F_SETFL, fcntl(ListenSocket, F_GETFL) | O_NONBLOCK);
+            return true;
+#endif
+        }
+
+        bool IsOpen() const { return File != nullptr || ListenSocket >= 0; }
+
+        void Close()
+        {
+            if (File != nullptr)
+            {
+                std::fclose(File);
+                File = nullptr;
+            }
+#ifndef _WIN32
+            for (const int client : Clients)
+            {
+                close(client);
+            }
+            Clients.clear();
+            if (ListenSocket >= 0)
+            {
+                close(ListenSocket);
+                unlink(SocketPath.c_str());
+                ListenSocket = -1;
+            }
+#endif
+        }
+
+        // Starts a run of the simulators with the given names, every simulator gets fresh metrics. precision converts simulation time
+        // to seconds.
+        void Attach(const std::vector<std::string>& simulatorNames, SimulationTime precision)
+        {
+            Precision      = std::max<SimulationTime>(precision, 1);
+            SimulatorCount = simulatorNames.size();
+            Metrics        = std::make_unique<SimulatorMetrics[]>(SimulatorCount);
+
+            RunHeader = std::format("# run {} simulators={}\n", ++Runs, SimulatorCount);
+            for (size_t i = 0; i < SimulatorCount; i++)
+            {
+                RunHeader += std::format("# simulator {} {}\n", i, simulatorNames[i]);
+            }
+            Write(RunHeader);
+        }
+
+        SimulatorMetrics& GetMetrics(size_t simulator) { return Metrics[simulator]; }
+
+        // Runs every model container of manager to its end time, and samples the metrics meanwhile when the reporter is open.
+        // The run itself is the loop of ModelManager::Update, the sampling thread adds nothing to it.
+        void Run(Ers::ModelManager& manager)
+        {
+            if (!IsOpen() || Metrics == nullptr)
+            {
+                while (manager.Count() > 0)
+                {
+                    manager.Update();
+                }
+                return;
+            }
+
+            const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            LastSample                                            = Sample{};
+            Stopping                                              = false;
+
+            std::thread sampler(
+                [this, startTime]
+                {
+                    std::unique_lock lock(StopMutex);
+                    while (!StopCondition.wait_for(lock, Interval, [this] { return Stopping; }))
+                    {
+                        WriteSample(startTime);
+                    }
+                });
+
+            while (manager.Count() > 0)
+            {
+                manager.Update();
+            }
+
+            {
+                std::lock_guard lock(StopMutex);
+                Stopping = true;
+            }
+            StopCondition.notify_one();
+            sampler.join();
+
+            WriteSample(startTime);
+        }
+
+      private:
+        struct Sample
+        {
+            double WallSeconds{0.0};
+            uint64_t Events{0};
+            uint64_t Delivered{0};
+        };
+
+        void WriteSample(std::chrono::steady_clock::time_point startTime)
+        {
+            Sample sample;
+            sample.WallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            SimulationTime minimumTime = std::numeric_limits<SimulationTime>::max();
+            SimulationTime maximumTime = 0;
+            std::string eventsBySimulator;
+            for (size_t i = 0; i < SimulatorCount; i++)
+            {
+                const SimulationTime now = Metrics[i].Now.load(std::memory_order_relaxed);
+                const uint64_t events    = Metrics[i].Events.load(std::memory_order_relaxed);
+                minimumTime              = std::min(minimumTime, now);
+                maximumTime              = std::max(maximumTime, now);
+                sample.Events += events;
+                sample.Delivered += Metrics[i].Delivered.load(std::memory_order_relaxed);
+                eventsBySimulator += std::format("{}{}", i == 0 ? "" : ",", events);
+            }
+            if (SimulatorCount == 0)
+            {
+                minimumTime = 0;
+            }
+
+            AcceptClients();
+
+            const double elapsed = std::max(sample.WallSeconds - LastSample.WallSeconds, 1e-9);
+            const double seconds = static_cast<double>(Precision);
+            Write(std::format(
+                "wall_s={:.3f} sim_time_s={:.3f} max_sim_time_s={:.3f} events={} events_per_s={:.0f} delivered={} delivered_per_s={:.0f} "
+                "events_by_simulator={}\n",
+                sample.WallSeconds, static_cast<double>(minimumTime) / seconds, static_cast<double>(maximumTime) / seconds, sample.Events,
+                static_cast<double>(sample.Events - LastSample.Events) / elapsed, sample.Delivered,
+                static_cast<double>(sample.Delivered - LastSample.Delivered) / elapsed, eventsBySimulator));
+            LastSample = sample;
+        }
+
+        // Clients that connect during a run get the header of the run first
+        void AcceptClients()
+        {
+#ifndef _WIN32
+            if (ListenSocket < 0)
+            {
+                return;
+            }
+
+            for (int client = accept(ListenSocket, nullptr, nullptr); client >= 0; client = accept(ListenSocket, nullptr, nullptr))
+            {
+                Clients.push_back(client);
+                SendToClient(client, RunHeader);
+            }
+#endif
+        }
+
+        void Write(const std::string& line)
+        {
+            if (File != nullptr)
+            {
+                std::fputs(line.c_str(), File);
+                std::fflush(File);
+            }
+#ifndef _WIN32
+            if (ListenSocket < 0)
+            {
+                return;
+            }
+
+            // A client that went away or can't keep up is dropped, the reporter never waits for one
+            std::erase_if(Clients, [&](int client) { return !SendToClient(client, line); });
+#endif
+        }
+
+#ifndef _WIN32
+        // Closes the client when the line can't be sent at once
+        static bool SendToClient(int client, const std::string& line)
+        {
+#ifdef MSG_NOSIGNAL
+            constexpr int flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+#else
+            constexpr int flags = MSG_DONTWAIT;
+#endif
+            if (send(client, line.data(), line.size(), flags) == static_cast<ssize_t>(line.size()))
+            {
+                return true;
+            }
+            close(client);
+            return false;
+        }
+#endif
+
+        std::chrono::milliseconds Interval{1000};
+        SimulationTime Precision{1};
+
+        std::unique_ptr<SimulatorMetrics[]> Metrics;
+        size_t SimulatorCount{0};
+        uint64_t Runs{0};
+        std::string RunHeader;
+        Sample LastSample;
+
+        std::mutex StopMutex;
+        std::condition_variable StopCondition;
+        bool Stopping{false};
+
+        std::FILE* File{nullptr};
+        int ListenSocket{-1};
+        std::string SocketPath;
+        std::vector<int> Clients;
+    };
+
+    // Starts a run of reporter for the simulators of modelContainer, and points the Metrics field of the Context of every submodel to
+    // the metrics of its simulator
+    template <typename Context = MetricsContext>
+    void AttachMetrics(Ers::ModelContainer& modelContainer, MetricsReporter& reporter)
+    {
+        const std::vector<Ers::Simulator> simulators = modelContainer.GetSimulators();
+
+        std::vector<std::string> names;
+        for (auto simulator : simulators)
+        {
+            names.push_back(simulator.GetName());
+        }
+        reporter.Attach(names, modelContainer.GetPrecision());
+
+        for (size_t i = 0; i < simulators.size(); i++)
+        {
+            auto simulator = simulators[i];
+            simulator.EnterSubModel();
+            Ers::SubModel::Get().GetSubModelContext<Context>().Metrics = &reporter.GetMetrics(i);
+            simulator.ExitSubModel();
+        }
+    }
+
+    template <typename Context = MetricsContext>
+    void DetachMetrics(Ers::ModelContainer& modelContainer)
+    {
+        for (auto simulator : modelContainer.GetSimulators())
+        {
+            simulator.EnterSubModel();
+            Ers::SubModel::Get().GetSubModelContext<Context>().Metrics = nullptr;
+            simulator.ExitSubModel();
+        }
+    }
+} // namespace ErsExamples
@@ -0,0 +1,425 @@
+#include "Ers/Logger.h"
+#include "Ers/Model/ModelContainer.h"
+#include "Ers/Model/ModelManager.h"
+#include "Ers/Model/Simulator/Simulator.h"
+#include "Ers/SubModel/Component/GlobalComponentTypes.h"
+#include "Ers/SubModel/DataComponent.h"
+#include "Ers/SubModel/EventScheduler.h"
+#include "Ers/SubModel/ScriptBehaviorComponent.h"
+#include "Ers/SubModel/SubModel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+
+#include <psapi.h>
+#endif
+
+namespace MoverModelScaled
+{
+    // Delay of the sync event that moves the objects to a target bin in another simulator
+    constexpr SimulationTime SyncDelay = 1;
+
+    // Simulation time units per second
+    constexpr SimulationTime ModelPrecision = 1'000'000;
+
+    // Which bin every mover moves its objects to
+    enum class Topology
+    {
+        // Every mover moves to the bin after its source bin, which is in the next simulator, so the simulators form a ring
+        OneToOne,
+        // Every mover moves to bin 0, so every simulator sends to the first one
+        AllToOne,
+        // Every mover moves to a random other bin, drawn once while building
+        Random,
+    };
+
+    struct ModelSettings
+    {
+        uint64_t BinCount{1000};
+        uint64_t MoverCount{1000};
+        uint64_t SimulatorCount{4};
+        Topology Kind{Topology::OneToOne};
+
+        uint64_t ObjectsPerBin{1000};
+        SimulationTime EndTime{10};
+        uint64_t Seed{1};
+    };
+
+    // Counters of a simulator, only touched by the thread that runs it
+    struct MoverCounters
+    {
+        uint64_t MoveEvents{0};
+        uint64_t SentMoves{0};
+        uint64_t ReceivedMoves{0};
+    };
+
+    struct BinComponent : public Ers::DataComponent
+    {
+        uint64_t Stored;
+
+        bool operator==(const BinComponent& other) const { return this == &other; }
+    };
+
+    struct MoveLocalEvent
+    {
+        EntityID Mover;
+
+        void OnEvent();
+
+        ERS_EVENT(Mover)
+    };
+
+    // Only carries the target bin and the number of objects, the minimal payload of a sync event
+    struct MoveSyncEvent : Ers::ISyncEvent<MoveSyncEvent>
+    {
+        EntityID TargetBin;
+        uint64_t NumberMoving;
+
+        static const char* GetName() { return "Move to target bin"; }
+
+        void OnSenderSide() {}
+
+        void OnTargetSide()
+        {
+            auto& targetSubModel = Ers::SubModel::Get();
+            targetSubModel.GetComponent<BinComponent>(TargetBin)->Stored += NumberMoving;
+            targetSubModel.GetSubModelContext<MoverCounters>().ReceivedMoves++;
+        }
+
+        ERS_EVENT(TargetBin, NumberMoving)
+    };
+
+    class MoveBehaviour : public Ers::ScriptBehaviorComponent
+    {
+    public:
+        MoveBehaviour() = default;
+
+        void OnStart();
+
+        EntityID Source{};
+        EntityID Target{};
+
+        // Set by the model builder, so a move doesn't look up the target simulator by name
+        uint32_t TargetSimulatorID{0};
+        bool TargetIsLocal{true};
+
+        uint32_t nMoving = 1;
+    };
+
+    void MoveBehaviour::OnStart()
+    {
+        Ers::EventScheduler::ScheduleLocalEvent(0, 0, MoveLocalEvent{ConnectedEntity});
+    }
+
+    void MoveLocalEvent::OnEvent()
+    {
+        auto& sourceSubModel = Ers::SubModel::Get();
+        auto mover           = sourceSubModel.GetComponent<MoveBehaviour>(Mover);
+        auto sourceBin       = sourceSubModel.GetComponent<BinComponent>(mover->Source);
+        auto& counters       = sourceSubModel.GetSubModelContext<MoverCounters>();
+        counters.MoveEvents++;
+
+        // Can't move objects if there are none, the mover stops
+        if (sourceBin->Stored < mover->nMoving)
+        {
+            return;
+        }
+
+        sourceBin->Stored -= mover->nMoving;
+
+        if (mover->TargetIsLocal)
+        {
+            sourceSubModel.GetComponent<BinComponent>(mover->Target)->Stored += mover->nMoving;
+        }
+        else
+        {
+            MoveSyncEvent data;
+            data.TargetBin    = mover->Target;
+            data.NumberMoving = mover->nMoving;
+            Ers::EventScheduler::ScheduleSyncEvent<MoveSyncEvent>(SyncDelay, mover->TargetSimulatorID, data);
+            counters.SentMoves++;
+        }
+
+        // Repeat MoveEvent
+        const SimulationTime delayTime = SimulationTime(sourceSubModel.SampleRandomGenerator() * sourceSubModel.GetModelPrecision());
+        Ers::EventScheduler::ScheduleLocalEvent(0, delayTime, MoveLocalEvent{Mover});
+    }
+
+    // Resident memory of the process in bytes, zero where it can't be read
+    uint64_t ResidentMemory()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            return counters.WorkingSetSize;
+        }
+        return 0;
+#else
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.starts_with("VmRSS:"))
+            {
+                return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+            }
+        }
+        return 0;
+#endif
+    }
+
+    const char* TopologyName(Topology topology)
+    {
+        switch (topology)
+        {
+            case Topology::OneToOne:
+                return "one-to-one";
+            case Topology::AllToOne:
+                return "all-to-one";
+            case Topology::Random:
+                return "random";
+        }
+        return "";
+    }
+
+    // Bins are spread over the simulators round robin, so bin b is in simulator b % SimulatorCount
+    uint64_t SimulatorOfBin(const ModelSettings& settings, uint64_t bin)
+    {
+        return bin % settings.SimulatorCount;
+    }
+
+    // The movers are spread over the bins round robin. With all-to-one bin 0 is only a target, unless it is the only bin.
+    uint64_t SourceBinOfMover(const ModelSettings& settings, uint64_t mover)
+    {
+        if (settings.Kind == Topology::AllToOne && settings.BinCount > 1)
+        {
+            return 1 + mover % (settings.BinCount - 1);
+        }
+        return mover % settings.BinCount;
+    }
+
+    uint64_t TargetBinOfMover(const ModelSettings& settings, uint64_t sourceBin, std::mt19937_64& random)
+    {
+        switch (settings.Kind)
+        {
+            case Topology::OneToOne:
+                return (sourceBin + 1) % settings.BinCount;
+            case Topology::AllToOne:
+                return 0;
+            case Topology::Random:
+            {
+                if (settings.BinCount == 1)
+                {
+                    return 0;
+                }
+                // Any bin but the source
+                const uint64_t bin = std::uniform_int_distribution<uint64_t>(0, settings.BinCount - 2)(random);
+                return bin < sourceBin ? bin : bin + 1;
+            }
+        }
+        return 0;
+    }
+
+    // Builds settings.SimulatorCount simulators with the bins and movers. Every mover is in the simulator of its source bin, and
+    // every pair of simulators that a mover sends across gets a dependency with the promise of the sync delay.
+    void BuildModel(Ers::ModelContainer& modelContainer, const ModelSettings& settings)
+    {
+        modelContainer.SetPrecision(ModelPrecision);
+        modelContainer.SetSeed(settings.Seed);
+
+        for (uint64_t s = 0; s < settings.SimulatorCount; s++)
+        {
+            modelContainer.AddSimulator(std::format("Simulator {}", s), Ers::SimulatorType::DiscreteEvent);
+        }
+        std::vector<Ers::Simulator> simulators = modelContainer.GetSimulators();
+
+        // Bins first, the movers need the entities of their target bins in the other simulators
+        std::vector<EntityID> bins(settings.BinCount);
+        for (uint64_t s = 0; s < settings.SimulatorCount; s++)
+        {
+            simulators[s].EnterSubModel();
+            auto& submodel = Ers::SubModel::Get();
+            for (uint64_t b = s; b < settings.BinCount; b += settings.SimulatorCount)
+            {
+                bins[b]     = submodel.CreateEntity(std::format("Bin {}", b));
+                auto bin    = submodel.AddComponent<BinComponent>(bins[b]);
+                bin->Stored = settings.ObjectsPerBin;
+            }
+            simulators[s].ExitSubModel();
+        }
+
+        // Drawn in mover order, so the random topology only depends on the seed
+        std::mt19937_64 random(settings.Seed);
+        std::vector<uint64_t> targetBins(settings.MoverCount);
+        for (uint64_t m = 0; m < settings.MoverCount; m++)
+        {
+            targetBins[m] = TargetBinOfMover(settings, SourceBinOfMover(settings, m), random);
+        }
+
+        std::set<std::pair<uint64_t, uint64_t>> dependencies;
+        for (uint64_t s = 0; s < settings.SimulatorCount; s++)
+        {
+            simulators[s].EnterSubModel();
+            auto& submodel = Ers::SubModel::Get();
+            for (uint64_t m = 0; m < settings.MoverCount; m++)
+            {
+                const uint64_t sourceBin = SourceBinOfMover(settings, m);
+                if (SimulatorOfBin(settings, sourceBin) != s)
+                {
+                    continue;
+                }
+
+                const uint64_t targetSimulator = SimulatorOfBin(settings, targetBins[m]);
+
+                const EntityID moverEntity = submodel.CreateEntity(std::format("Mover {}", m));
+                auto mover                 = submodel.AddComponent<MoveBehaviour>(moverEntity);
+                mover->Source              = bins[sourceBin];
+                mover->Target              = bins[targetBins[m]];
+                mover->TargetSimulatorID   = simulators[targetSimulator].GetID();
+                mover->TargetIsLocal       = targetSimulator == s;
+
+                if (!mover->TargetIsLocal)
+                {
+                    dependencies.emplace(s, targetSimulator);
+                }
+            }
+            simulators[s].ExitSubModel();
+        }
+
+        // Several movers share an edge, so every edge keeps the promise of the sync delay. It never needs to be replaced, since no
+        // sync event arrives earlier than the sync delay after it was scheduled, see LookaheadPromise.
+        for (const auto& [from, to] : dependencies)
+        {
+            modelContainer.AddSimulatorDependency(simulators[from], simulators[to]);
+            simulators[from].EnterSubModel();
+            Ers::EventScheduler::SetPromise(simulators[to].GetID(), SyncDelay);
+            simulators[from].ExitSubModel();
+        }
+
+        Ers::Logger::Debug(std::format("{} simulator dependencies", dependencies.size()));
+    }
+
+    struct MeasureResult
+    {
+        uint64_t Events{0};
+        uint64_t SyncEvents{0};
+        double BuildSeconds{0.0};
+        double RunSeconds{0.0};
+        double BytesPerEntity{0.0};
+        uint64_t RunMemoryGrowth{0};
+    };
+
+    MeasureResult MeasureModel(const ModelSettings& settings)
+    {
+        MeasureResult result;
+
+        Ers::ModelManager& manager         = Ers::ModelManager::Get();
+        Ers::ModelContainer modelContainer = Ers::ModelContainer::Create();
+
+        const uint64_t memoryBeforeBuild                               = ResidentMemory();
+        const std::chrono::high_resolution_clock::time_point buildTime = std::chrono::high_resolution_clock::now();
+        BuildModel(modelContainer, settings);
+        result.BuildSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - buildTime).count();
+
+        // The memory of the simulators themselves is spread over the entities as well
+        const uint64_t memoryAfterBuild = ResidentMemory();
+        result.BytesPerEntity = static_cast<double>(memoryAfterBuild - std::min(memoryBeforeBuild, memoryAfterBuild)) /
+                                static_cast<double>(settings.BinCount + settings.MoverCount);
+
+        manager.AddModelContainer(modelContainer, settings.EndTime * ModelPrecision);
+
+        const std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+        while (manager.Count() > 0)
+        {
+            manager.Update();
+        }
+        result.RunSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+        const uint64_t memoryAfterRun = ResidentMemory();
+        result.RunMemoryGrowth        = memoryAfterRun - std::min(memoryAfterBuild, memoryAfterRun);
+
+        // Every move is a local event, a move to another simulator is a sync event on top of that
+        for (auto simulator : modelContainer.GetSimulators())
+        {
+            simulator.EnterSubModel();
+            const auto& counters = Ers::SubModel::Get().GetSubModelContext<MoverCounters>();
+            result.Events += counters.MoveEvents + counters.ReceivedMoves;
+            result.SyncEvents += counters.ReceivedMoves;
+            simulator.ExitSubModel();
+        }
+
+        Ers::Logger::Info(std::format(
+            "{} bins, {} movers, {} simulators, {}: build {:.3f} s, {:.0f} bytes per entity; run {:.3f} s, {} events ({} sync), {:.0f} "
+            "events/s, memory growth {} KiB",
+            settings.BinCount, settings.MoverCount, settings.SimulatorCount, TopologyName(settings.Kind), result.BuildSeconds,
+            result.BytesPerEntity, result.RunSeconds, result.Events, result.SyncEvents,
+            result.RunSeconds > 0.0 ? static_cast<double>(result.Events) / result.RunSeconds : 0.0, result.RunMemoryGrowth / 1024));
+        return result;
+    }
+
+    bool ParseTopology(std::string_view name, Topology& topology)
+    {
+        for (const Topology candidate : {Topology::OneToOne, Topology::AllToOne, Topology::Random})
+        {
+            if (name == TopologyName(candidate))
+            {
+                topology = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+} // namespace MoverModelScaled
+
+int main(int argc, char** argv)
+{
+    Ers::Initialize();
+
+    // Register types
+    Ers::ComponentRegistry<MoverModelScaled::BinComponent>::Register();
+    Ers::ComponentRegistry<MoverModelScaled::MoveBehaviour>::Register();
+    Ers::EventScheduler::RegisterLocalEvent<MoverModelScaled::MoveLocalEvent>();
+    Ers::EventScheduler::RegisterSyncEvent<MoverModelScaled::MoveSyncEvent>();
+
+    // Arguments: [topology] [bins movers simulators]. Without counts the entity counts are swept from a thousand to a million.
+    MoverModelScaled::ModelSettings settings;
+    if (argc > 1 && !MoverModelScaled::ParseTopology(argv[1], settings.Kind))
+    {
+        Ers::Logger::Info(std::format("Unknown topology {}, expected one-to-one, all-to-one or random", argv[1]));
+        Ers::Uninitialize();
+        return 1;
+    }
+
+    if (argc > 4)
+    {
+        settings.BinCount       = std::max<uint64_t>(std::strtoull(argv[2], nullptr, 10), 1);
+        settings.MoverCount     = std::strtoull(argv[3], nullptr, 10);
+        settings.SimulatorCount = std::max<uint64_t>(std::strtoull(argv[4], nullptr, 10), 1);
+        MoverModelScaled::MeasureModel(settings);
+    }
+    else
+    {
+        for (const uint64_t count : {1'000, 10'000, 100'000, 1'000'000})
+        {
+            settings.BinCount   = count;
+            settings.MoverCount = count;
+            MoverModelScaled::MeasureModel(settings);
+        }
+    }
+
+    Ers::Uninitialize();
+    return 0;
+}
@@ -8,11 +8,19 @@
 #include "Ers/SubModel/ScriptBehaviorComponent.h"
 #include "Ers/SubModel/SubModel.h"
 
+#include "LookaheadPromise.h"
+#include "MetricsReporter.h"
+
+#include <chrono>
+#include <cstring>
 #include <format>
 #include <queue>
 
 namespace MoverModelSync
 {
+    // Delay of the sync event that moves the objects to the target bin
+    constexpr SimulationTime SyncDelay = 1;
+
     struct BinComponent : public Ers::DataComponent
     {
         uint64_t Stored;
@@ -22,29 +30,33 @@ namespace MoverModelSync
     
     struct MoveLocalEvent
     {
+        EntityID Mover;
         EntityID Source;
         EntityID Target;
         uint32_t nMoving;
 
+        // Time at which the event fires, reported to the metrics and used for the promise
+        SimulationTime Time;
+
         void OnEvent();
 
-        ERS_EVENT(Source, Target, nMoving)
+        ERS_EVENT(Mover, Source, Target, nMoving, Time)
     };
 
 
     // Data send via the sync event
     struct MoverModelSyncEvent : Ers::ISyncEvent<MoverModelSyncEvent>
     {
+        EntityID Mover;
         uint64_t NumberMoving;
+        SimulationTime Time;
 
         static const char* GetName() { return "Move to target"; }
 
-        void OnSenderSide()
-        {
-            // This event is executed in the source submodel. This function is intended to gather the state from the source to send it
-            // to the target. This event is called on the exact time as the target executes the sync event The event appears to be
-            // instantaneous for both the source and target
-        }
+        // This event is executed in the source submodel. This function is intended to gather the state from the source to send it
+        // to the target. This event is called on the exact time as the target executes the sync event The event appears to be
+        // instantaneous for both the source and target
+        void OnSenderSide();
 
         void OnTargetSide()
         {
@@ -57,9 +69,15 @@ namespace MoverModelSync
             // Store object in target bin
             auto* targetBin = targetBinEntity.GetComponent<BinComponent>();
             targetBin->Stored += NumberMoving;
+
+            if (auto* metrics = targetSubModel.GetSubModelContext<ErsExamples::MetricsContext>().Metrics)
+            {
+                metrics->CountEvent(Time);
+                metrics->CountDelivered(NumberMoving);
+            }
         }
 
-        ERS_EVENT(NumberMoving)
+        ERS_EVENT(Mover, NumberMoving, Time)
     };
 
     class MoveBehaviour : public Ers::ScriptBehaviorComponent
@@ -72,15 +90,47 @@ namespace MoverModelSync
         EntityID Source{};
         EntityID Target{};
 
+        // Set by the model builder, so neither a move nor a promise looks up the target simulator by name
+        uint32_t TargetSimulatorID{0};
+
         uint32_t nMoving = 1;
+
+        // Promise to the target simulator, only updated when automatic promises are on. The time until the next move shrinks as the
+        // source simulator advances, so the promise is replaced in every event of the source simulator, see LookaheadPromise.
+        bool AutomaticPromise = true;
+        ErsExamples::LookaheadPromise TargetPromise{SyncDelay};
+
+        // Time of the next move, once the source bin is empty the mover stops and never sends again
+        SimulationTime NextMoveTime = 0;
+        bool Stopped                = false;
+
+        void UpdateTargetPromise(SimulationTime now);
     };
 
+    void MoveBehaviour::UpdateTargetPromise(SimulationTime now)
+    {
+        if (!AutomaticPromise)
+        {
+            return;
+        }
+
+        TargetPromise.Update(TargetSimulatorID, Stopped ? ErsExamples::LookaheadPromise::Unbounded : NextMoveTime - now);
+    }
+
+    void MoverModelSyncEvent::OnSenderSide()
+    {
+        // Runs at the arrival time in the source simulator, which advances its time, so the mover promises again from there
+        Ers::SubModel::Get().GetComponent<MoveBehaviour>(Mover)->UpdateTargetPromise(Time);
+    }
+
     void MoveBehaviour::OnStart()
     {
         MoveLocalEvent eventData;
+        eventData.Mover  = ConnectedEntity;
         eventData.Source = Source;
         eventData.Target = Target;
         eventData.nMoving = nMoving;
+        eventData.Time    = 0;
         Ers::EventScheduler::ScheduleLocalEvent(0, 0, eventData);
     }
 
@@ -88,28 +138,42 @@ namespace MoverModelSync
     {
         auto& sourceSubModel = Ers::SubModel::Get();
         auto sourceBin = sourceSubModel.GetComponent<BinComponent>(Source);
+        auto mover     = sourceSubModel.GetComponent<MoveBehaviour>(Mover);
+
+        if (auto* metrics = sourceSubModel.GetSubModelContext<ErsExamples::MetricsContext>().Metrics)
+        {
+            metrics->CountEvent(Time);
+        }
+
         if (sourceBin->Stored == 0)
-            return; // Can't move objects if there are none
+        {
+            // Can't move objects if there are none, and the mover stops, so the target never has to wait for it again
+            mover->Stopped = true;
+            mover->UpdateTargetPromise(Time);
+            return;
+        }
 
         sourceBin->Stored -= nMoving;
 
-        auto simulator = sourceSubModel.GetSimulator();
-        const int32_t targetSimulatorId = simulator.FindOutgoingDependency("Target Simulator").GetID();
-
         // Send object to target bin in other simulator, via sync event
-        SimulationTime noDelay(1);
         MoverModelSyncEvent data;
+        data.Mover        = Mover;
         data.NumberMoving = nMoving;
-        Ers::EventScheduler::ScheduleSyncEvent<MoverModelSyncEvent>(noDelay, targetSimulatorId, data);
+        data.Time         = Time + SyncDelay;
+        Ers::EventScheduler::ScheduleSyncEvent<MoverModelSyncEvent>(SyncDelay, mover->TargetSimulatorID, data);
 
         // Repeat MoveEvent
         double random                  = sourceSubModel.SampleRandomGenerator() * sourceSubModel.GetModelPrecision();
         const SimulationTime delayTime = SimulationTime(random);
-        Ers::EventScheduler::ScheduleLocalEvent(0, delayTime, MoveLocalEvent{Source, Target, nMoving});
+        Ers::EventScheduler::ScheduleLocalEvent(0, delayTime, MoveLocalEvent{Mover, Source, Target, nMoving, Time + delayTime});
+
+        // The next move is the next send, so the target can run up to it
+        mover->NextMoveTime = Time + delayTime;
+        mover->UpdateTargetPromise(Time);
     }
 } // namespace MoverModelSync
 
-int main()
+int main(int argc, char** argv)
 {
     Ers::Initialize();
 
@@ -119,6 +183,9 @@ int main()
     Ers::EventScheduler::RegisterLocalEvent<MoverModelSync::MoveLocalEvent>();
     Ers::EventScheduler::RegisterSyncEvent<MoverModelSync::MoverModelSyncEvent>();
 
+    // "static-promise" keeps the promise at the sync delay, to compare against the automatic promises
+    const bool automaticPromise = !(argc > 1 && std::strcmp(argv[1], "static-promise") == 0);
+
     const uint64_t nObjects = 10000;
     auto endTimeForModel = SimulationTime(10000);
     endTimeForModel *= 1'000'000; // Apply model precision
@@ -147,24 +214,46 @@ int main()
     auto mover = Ers::SubModel::Get().AddComponent<MoverModelSync::MoveBehaviour>(moverEntity);
     mover->Source = sourceEntity;
     mover->Target = targetEntity;
+    mover->TargetSimulatorID = targetSimulator.GetID();
+    mover->AutomaticPromise = automaticPromise;
 
     sourceSimulator.ExitSubModel();
 
     // Add source simulator as dependency to target simulator, required for sync event
     modelContainer.AddSimulatorDependency(sourceSimulator, targetSimulator);
 
+    // The first move is at the start, so at first the target can only run ahead by the sync delay
+    sourceSimulator.EnterSubModel();
+    ErsExamples::LookaheadPromise(MoverModelSync::SyncDelay).Update(targetSimulator.GetID(), 0);
+    sourceSimulator.ExitSubModel();
+
     Ers::Logger::Info(std::format("Source bin has {} objects, Target bin has {} objects", source->Stored, target->Stored));
 
     Ers::Logger::Debug("Starting...");
     manager.AddModelContainer(modelContainer, endTimeForModel);
 
-    while (manager.Count() > 0)
+    // Without ERS_METRICS the run is the plain loop of ModelManager::Update
+    ErsExamples::MetricsReporter metrics;
+    const std::string metricsTarget = ErsExamples::MetricsReporter::TargetFromEnvironment();
+    if (!metricsTarget.empty() && metrics.Open(metricsTarget, ErsExamples::MetricsReporter::IntervalFromEnvironment()))
+    {
+        ErsExamples::AttachMetrics(modelContainer, metrics);
+    }
+    else if (!metricsTarget.empty())
     {
-        manager.Update();
+        Ers::Logger::Info(std::format("Can't open metrics target {}", metricsTarget));
     }
 
+    const std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+    metrics.Run(manager);
+    const std::chrono::duration<double> runTime = std::chrono::high_resolution_clock::now() - startTime;
+
     sourceSimulator.EnterSubModel();
     source = Ers::SubModel::Get().GetComponent<MoverModelSync::BinComponent>(sourceEntity);
+    mover  = Ers::SubModel::Get().GetComponent<MoverModelSync::MoveBehaviour>(moverEntity);
+    Ers::Logger::Info(std::format(
+        "{} promises: {:.3f} s, {} promises, mean lookahead {:.3f} s", automaticPromise ? "Automatic" : "Static", runTime.count(),
+        mover->TargetPromise.Promises, mover->TargetPromise.MeanLookahead() / 1'000'000));
     sourceSimulator.ExitSubModel();
     targetSimulator.EnterSubModel();
     target = Ers::SubModel::Get().GetComponent<MoverModelSync::BinComponent>(targetEntity);